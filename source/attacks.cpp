@@ -0,0 +1,316 @@
+#include "attacks.h"
+
+#include "bit_board.h"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace chess {
+
+namespace {
+
+using detail::on_board;
+using detail::square_bit;
+using detail::Step;
+
+constexpr std::array<Step, 4> bishop_steps{{{1, 1}, {1, -1}, {-1, 1}, {-1, -1}}};
+constexpr std::array<Step, 4> rook_steps{{{1, 0}, {-1, 0}, {0, 1}, {0, -1}}};
+
+// Found offline with a fixed-seed sparse random search. BitBoard bit order is little-endian rank-file order with
+// the files mirrored, which maps every slider ray onto a slider ray, so the same magics index both.
+constexpr std::array<std::uint64_t, square_count> bishop_magics{
+    0x10102002004A1420ULL,
+    0x8020040400584008ULL,
+    0x10510800811201C8ULL,
+    0x5204042080000088ULL,
+    0x2204106880000002ULL,
+    0x1401042004000000ULL,
+    0x0400880410042004ULL,
+    0x0028208200A02020ULL,
+    0x1500241990010E00ULL,
+    0x8001200182020A40ULL,
+    0x40004101030B0000ULL,
+    0x8002041042000100ULL,
+    0x4010011041020038ULL,
+    0x0000010421044000ULL,
+    0x1500210808020A00ULL,
+    0x8000088400880520ULL,
+    0x0405004010040100ULL,
+    0x1005823210040108ULL,
+    0x2708008102040011ULL,
+    0x4048200404009100ULL,
+    0x0018104101400024ULL,
+    0x0003000601190101ULL,
+    0x8004803108491000ULL,
+    0x8014241200820800ULL,
+    0x0006E080100C3040ULL,
+    0x0501044A11041800ULL,
+    0x9020300008004045ULL,
+    0x0894080000220040ULL,
+    0x1001010083104000ULL,
+    0x5004030040900080ULL,
+    0x000400422C012400ULL,
+    0x0002128698404812ULL,
+    0x1010108404900440ULL,
+    0x0928021182084100ULL,
+    0x2006080409020024ULL,
+    0x1010202020180080ULL,
+    0xA010008200202200ULL,
+    0x2098015100019004ULL,
+    0x0002041440810811ULL,
+    0x802A02020000B098ULL,
+    0x0009015090004060ULL,
+    0x4000821082081001ULL,
+    0x0100210040420800ULL,
+    0x0800004010488A00ULL,
+    0x2000081104004040ULL,
+    0x4C8E029015000082ULL,
+    0x0420340322224842ULL,
+    0x1298260043400210ULL,
+    0x0000822802400008ULL,
+    0x00008A0101600000ULL,
+    0x3040003412080021ULL,
+    0x3040290220884800ULL,
+    0x4A1500401041004AULL,
+    0x8010200282020781ULL,
+    0x0020203142209091ULL,
+    0x0070300600902110ULL,
+    0x0040808800B62048ULL,
+    0x0000810400C44420ULL,
+    0x00080400440C0441ULL,
+    0x8340080020840411ULL,
+    0x0000000104208200ULL,
+    0x0000800810D00080ULL,
+    0x0400530411080200ULL,
+    0x4040702400932244ULL,
+};
+
+constexpr std::array<std::uint64_t, square_count> rook_magics{
+    0x1080004008801020ULL,
+    0x0840092002C03000ULL,
+    0x1900200010400900ULL,
+    0x0880100008000480ULL,
+    0x4200100420080200ULL,
+    0x8100020100080400ULL,
+    0x0200040110886200ULL,
+    0x0200008040220411ULL,
+    0x0404800084400220ULL,
+    0x0000401000402000ULL,
+    0x0086001081220440ULL,
+    0x0408800800100280ULL,
+    0x000A001201040820ULL,
+    0x8848800200840080ULL,
+    0x4001000100040200ULL,
+    0x0442000102105084ULL,
+    0x9080010020804100ULL,
+    0x0040404000201009ULL,
+    0x0000808010002009ULL,
+    0x2200090021D00100ULL,
+    0x0008008008040080ULL,
+    0x0004004002010040ULL,
+    0x0011040008015042ULL,
+    0x00000A0001768104ULL,
+    0x0000800080204009ULL,
+    0x2010004140002001ULL,
+    0x9800200280100080ULL,
+    0x1000100080080080ULL,
+    0x0442000A00049020ULL,
+    0x2100040080020080ULL,
+    0x0800120400900148ULL,
+    0x0010040A00128541ULL,
+    0x2800804000800030ULL,
+    0x1010002000400041ULL,
+    0x4000200011004100ULL,
+    0x0610008410800800ULL,
+    0x0400802402800800ULL,
+    0xC100020080800400ULL,
+    0x0002000802000401ULL,
+    0x0182085882000401ULL,
+    0x0220204000808000ULL,
+    0x2860100040024022ULL,
+    0x0001002004110040ULL,
+    0x99101042000A0020ULL,
+    0x0004080004008080ULL,
+    0x0010040002008080ULL,
+    0x2012004881020004ULL,
+    0x8300842444820011ULL,
+    0x0088403882010200ULL,
+    0x0820400080210100ULL,
+    0x0110910040A00300ULL,
+    0x0801100280080480ULL,
+    0x0242009008200600ULL,
+    0x1002000489500200ULL,
+    0x0040800200010080ULL,
+    0x0091800041000080ULL,
+    0x0000209300488001ULL,
+    0x04C1002414824001ULL,
+    0x020020000B001041ULL,
+    0x7000100004200901ULL,
+    0x8002002004100802ULL,
+    0x30010002084C0007ULL,
+    0x0888221800813004ULL,
+    0x4000002840840112ULL,
+};
+
+std::uint64_t slow_sliding_attacks(const Square square, const std::uint64_t occupied, const std::array<Step, 4>& steps)
+{
+    std::uint64_t attacks = 0;
+    for (const auto step : steps) {
+        for (int rank = square / 8 + step.rank, file = square % 8 + step.file; on_board(rank, file);
+             rank += step.rank, file += step.file) {
+            attacks |= square_bit(rank, file);
+            if ((occupied & square_bit(rank, file)) != 0) {
+                break;
+            }
+        }
+    }
+    return attacks;
+}
+
+// squares whose occupancy can change the attack set, i.e. every ray square except the last one on the edge
+std::uint64_t relevant_occupancy_mask(const Square square, const std::array<Step, 4>& steps)
+{
+    std::uint64_t mask = 0;
+    for (const auto step : steps) {
+        for (int rank = square / 8 + step.rank, file = square % 8 + step.file;
+             on_board(rank + step.rank, file + step.file);
+             rank += step.rank, file += step.file) {
+            mask |= square_bit(rank, file);
+        }
+    }
+    return mask;
+}
+
+// The eight slider directions as a shift of the whole board: left shifts for the directions that raise the square
+// index and right shifts for the ones that lower it, each with the squares a shifted bit can land on without
+// wrapping round a file edge. Lanes are ordered to share shift amounts, rook-like directions first.
+constexpr std::array<std::uint64_t, 4> fill_shifts{1, 8, 7, 9};
+constexpr std::array<std::uint64_t, 4> left_fill_masks{
+    ~detail::file_0, ~std::uint64_t{0}, ~detail::file_7, ~detail::file_0
+};
+constexpr std::array<std::uint64_t, 4> right_fill_masks{
+    ~detail::file_7, ~std::uint64_t{0}, ~detail::file_0, ~detail::file_7
+};
+
+#if defined(__AVX2__)
+
+__m256i load_lanes(const std::array<std::uint64_t, 4>& lanes) noexcept
+{
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.data()));
+}
+
+// Kogge-Stone: each step doubles how far the sliders have spread through empty squares, so three steps cover the
+// seven squares of a ray, and a last shift steps onto the first blocker.
+template <bool Left>
+__m256i occluded_fill_attacks(__m256i sliders, const __m256i empty, const __m256i masks) noexcept
+{
+    const auto shift = [](const __m256i bits, const __m256i amounts) {
+        return Left ? _mm256_sllv_epi64(bits, amounts) : _mm256_srlv_epi64(bits, amounts);
+    };
+    const auto once = load_lanes(fill_shifts);
+    const auto twice = _mm256_add_epi64(once, once);
+    const auto four_times = _mm256_add_epi64(twice, twice);
+    auto propagators = _mm256_and_si256(empty, masks);
+    sliders = _mm256_or_si256(sliders, _mm256_and_si256(propagators, shift(sliders, once)));
+    propagators = _mm256_and_si256(propagators, shift(propagators, once));
+    sliders = _mm256_or_si256(sliders, _mm256_and_si256(propagators, shift(sliders, twice)));
+    propagators = _mm256_and_si256(propagators, shift(propagators, twice));
+    sliders = _mm256_or_si256(sliders, _mm256_and_si256(propagators, shift(sliders, four_times)));
+    return _mm256_and_si256(shift(sliders, once), masks);
+}
+
+#else
+
+template <bool Left>
+std::uint64_t occluded_fill_attacks(
+    std::uint64_t sliders, const std::uint64_t empty, const int shift, const std::uint64_t mask
+) noexcept
+{
+    const auto shifted = [](const std::uint64_t bits, const int amount) {
+        return Left ? bits << amount : bits >> amount;
+    };
+    auto propagators = empty & mask;
+    sliders |= propagators & shifted(sliders, shift);
+    propagators &= shifted(propagators, shift);
+    sliders |= propagators & shifted(sliders, 2 * shift);
+    propagators &= shifted(propagators, 2 * shift);
+    sliders |= propagators & shifted(sliders, 4 * shift);
+    return shifted(sliders, shift) & mask;
+}
+
+#endif
+
+} // namespace
+
+BitBoard
+slider_attacks_of(const BitBoard orthogonal_sliders, const BitBoard diagonal_sliders, const BitBoard occupied) noexcept
+{
+    const auto orthogonal = orthogonal_sliders.to_ullong();
+    const auto diagonal = diagonal_sliders.to_ullong();
+#if defined(__AVX2__)
+    const auto sliders = _mm256_setr_epi64x(
+        static_cast<long long>(orthogonal), static_cast<long long>(orthogonal), static_cast<long long>(diagonal),
+        static_cast<long long>(diagonal)
+    );
+    const auto empty = _mm256_set1_epi64x(static_cast<long long>(~occupied.to_ullong()));
+    const auto attacks = _mm256_or_si256(
+        occluded_fill_attacks<true>(sliders, empty, load_lanes(left_fill_masks)),
+        occluded_fill_attacks<false>(sliders, empty, load_lanes(right_fill_masks))
+    );
+    const auto halves = _mm_or_si128(_mm256_castsi256_si128(attacks), _mm256_extracti128_si256(attacks, 1));
+    return BitBoard{static_cast<std::uint64_t>(_mm_cvtsi128_si64(halves) | _mm_extract_epi64(halves, 1))};
+#else
+    const std::array<std::uint64_t, 4> sliders{orthogonal, orthogonal, diagonal, diagonal};
+    const auto empty = ~occupied.to_ullong();
+    std::uint64_t attacks = 0;
+    for (std::size_t lane = 0; lane < sliders.size(); ++lane) {
+        const auto shift = static_cast<int>(fill_shifts[lane]);
+        attacks |= occluded_fill_attacks<true>(sliders[lane], empty, shift, left_fill_masks[lane]);
+        attacks |= occluded_fill_attacks<false>(sliders[lane], empty, shift, right_fill_masks[lane]);
+    }
+    return BitBoard{attacks};
+#endif
+}
+
+SlidingAttackTable::SlidingAttackTable(const Slider slider)
+{
+    const auto& steps = (slider == Slider::bishop) ? bishop_steps : rook_steps;
+    const auto& magics = (slider == Slider::bishop) ? bishop_magics : rook_magics;
+
+    std::uint32_t offset = 0;
+    for (Square square = 0; square < square_count; ++square) {
+        auto& entry = entries_[square];
+        entry.mask = relevant_occupancy_mask(square, steps);
+        entry.magic = magics[square];
+        entry.offset = offset;
+        entry.shift = static_cast<std::uint32_t>(square_count - std::popcount(entry.mask));
+        offset += std::uint32_t{1} << std::popcount(entry.mask);
+    }
+    attacks_.resize(offset);
+
+    for (Square square = 0; square < square_count; ++square) {
+        const auto& entry = entries_[square];
+        // enumerate every subset of the mask (Carry-Rippler)
+        std::uint64_t occupied = 0;
+        do {
+            auto& attacks = attacks_[entry.offset + entry.index(occupied)];
+            const auto expected = slow_sliding_attacks(square, occupied, steps);
+            assert((attacks == 0 || attacks == expected) && "magic index collision");
+            attacks = expected;
+            occupied = (occupied - entry.mask) & entry.mask;
+        } while (occupied != 0);
+    }
+}
+
+const SlidingAttackTable bishop_attack_table{SlidingAttackTable::Slider::bishop};
+const SlidingAttackTable rook_attack_table{SlidingAttackTable::Slider::rook};
+
+} // namespace chess
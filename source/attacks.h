@@ -0,0 +1,330 @@
+#pragma once
+
+#include "bit_board.h"
+#include "pieces.h"
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace chess {
+
+// Index of a position's bit within BitBoard::to_ullong(), used to address the precomputed attack tables.
+using Square = int;
+inline constexpr Square square_count = 64;
+
+[[nodiscard]] inline Square to_square(const BitBoard position) noexcept
+{
+    assert(position.has_single_position());
+    return std::countr_zero(position.to_ullong());
+}
+
+[[nodiscard]] constexpr BitBoard to_bitboard(const Square square) noexcept
+{
+    return BitBoard{std::uint64_t{1} << square};
+}
+
+// The squares of a bitboard in increasing order, walked by counting trailing zeros and clearing the lowest set bit,
+// so that range-for loops and std::ranges algorithms over a board's squares don't build a container.
+class SquareRange : public std::ranges::view_interface<SquareRange>
+{
+  public:
+    class Iterator
+    {
+      public:
+        using value_type = Square;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        constexpr Iterator() noexcept = default;
+        constexpr explicit Iterator(const std::uint64_t bits) noexcept : bits_{bits} {}
+
+        [[nodiscard]] constexpr Square operator*() const noexcept
+        {
+            assert(bits_ != 0 && "dereferencing the end of a SquareRange");
+            return std::countr_zero(bits_);
+        }
+        constexpr Iterator& operator++() noexcept
+        {
+            bits_ &= bits_ - 1;
+            return *this;
+        }
+        constexpr Iterator operator++(int) noexcept
+        {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+        friend constexpr bool operator==(Iterator, Iterator) noexcept = default;
+
+      private:
+        // the squares not yet visited
+        std::uint64_t bits_{0};
+    };
+
+    constexpr SquareRange() noexcept = default;
+    constexpr explicit SquareRange(const BitBoard board) noexcept : bits_{board.to_ullong()} {}
+
+    [[nodiscard]] constexpr Iterator begin() const noexcept
+    {
+        return Iterator{bits_};
+    }
+    [[nodiscard]] constexpr Iterator end() const noexcept
+    {
+        return Iterator{};
+    }
+    [[nodiscard]] constexpr std::size_t size() const noexcept
+    {
+        return static_cast<std::size_t>(std::popcount(bits_));
+    }
+
+  private:
+    std::uint64_t bits_{0};
+};
+
+[[nodiscard]] constexpr SquareRange squares(const BitBoard board) noexcept
+{
+    return SquareRange{board};
+}
+
+namespace detail {
+
+// BitBoard bit order is little-endian rank-file order with the files mirrored. Rank 0 is white's back rank; the
+// mirrored files don't matter to any of the tables below, which treat both sides of the board alike.
+struct Step
+{
+    int rank;
+    int file;
+};
+
+[[nodiscard]] constexpr bool on_board(const int rank, const int file) noexcept
+{
+    return rank >= 0 && rank < 8 && file >= 0 && file < 8;
+}
+
+[[nodiscard]] constexpr std::uint64_t square_bit(const int rank, const int file) noexcept
+{
+    return std::uint64_t{1} << (rank * 8 + file);
+}
+
+// the files at either edge and one in from them, in BitBoard's mirrored order
+inline constexpr std::uint64_t file_0{0x01'01'01'01'01'01'01'01};
+inline constexpr std::uint64_t file_1{file_0 << 1};
+inline constexpr std::uint64_t file_6{file_0 << 6};
+inline constexpr std::uint64_t file_7{file_0 << 7};
+
+using SquareTable = std::array<BitBoard, square_count>;
+using SquarePairTable = std::array<SquareTable, square_count>;
+
+template <std::size_t N>
+constexpr SquareTable make_step_attack_table(const std::array<Step, N>& steps) noexcept
+{
+    SquareTable table{};
+    for (Square square = 0; square < square_count; ++square) {
+        std::uint64_t attacks = 0;
+        for (const auto step : steps) {
+            const auto rank = square / 8 + step.rank;
+            const auto file = square % 8 + step.file;
+            if (on_board(rank, file)) {
+                attacks |= square_bit(rank, file);
+            }
+        }
+        table[square] = BitBoard{attacks};
+    }
+    return table;
+}
+
+// Step from one square towards another along a shared rank, file or diagonal, or {0, 0} if they share none.
+[[nodiscard]] constexpr Step step_towards(const Square from, const Square to) noexcept
+{
+    const auto rank_distance = to / 8 - from / 8;
+    const auto file_distance = to % 8 - from % 8;
+    const auto sign = [](const int value) { return (value > 0) - (value < 0); };
+    const bool aligned = rank_distance == 0 || file_distance == 0 || rank_distance == file_distance ||
+                         rank_distance == -file_distance;
+    if (from == to || !aligned) {
+        return {0, 0};
+    }
+    return {sign(rank_distance), sign(file_distance)};
+}
+
+constexpr SquarePairTable make_between_table() noexcept
+{
+    SquarePairTable table{};
+    for (Square from = 0; from < square_count; ++from) {
+        for (Square to = 0; to < square_count; ++to) {
+            const auto step = step_towards(from, to);
+            if (step.rank == 0 && step.file == 0) {
+                continue;
+            }
+            std::uint64_t between = 0;
+            for (int rank = from / 8 + step.rank, file = from % 8 + step.file; rank * 8 + file != to;
+                 rank += step.rank, file += step.file) {
+                between |= square_bit(rank, file);
+            }
+            table[from][to] = BitBoard{between};
+        }
+    }
+    return table;
+}
+
+constexpr SquarePairTable make_line_table() noexcept
+{
+    SquarePairTable table{};
+    for (Square from = 0; from < square_count; ++from) {
+        for (Square to = 0; to < square_count; ++to) {
+            const auto step = step_towards(from, to);
+            if (step.rank == 0 && step.file == 0) {
+                continue;
+            }
+            std::uint64_t line = square_bit(from / 8, from % 8);
+            for (const auto direction : {step, Step{-step.rank, -step.file}}) {
+                for (int rank = from / 8 + direction.rank, file = from % 8 + direction.file; on_board(rank, file);
+                     rank += direction.rank, file += direction.file) {
+                    line |= square_bit(rank, file);
+                }
+            }
+            table[from][to] = BitBoard{line};
+        }
+    }
+    return table;
+}
+
+inline constexpr std::array<Step, 8> knight_steps{
+    {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}}
+};
+inline constexpr std::array<Step, 8> king_steps{
+    {{1, 1}, {1, 0}, {1, -1}, {0, 1}, {0, -1}, {-1, 1}, {-1, 0}, {-1, -1}}
+};
+inline constexpr std::array<Step, 2> black_pawn_steps{{{-1, 1}, {-1, -1}}};
+inline constexpr std::array<Step, 2> white_pawn_steps{{{1, 1}, {1, -1}}};
+
+} // namespace detail
+
+inline constexpr detail::SquareTable knight_attack_table = detail::make_step_attack_table(detail::knight_steps);
+inline constexpr detail::SquareTable king_attack_table = detail::make_step_attack_table(detail::king_steps);
+// indexed by PieceColor, then by the square the pawn stands on
+inline constexpr std::array<detail::SquareTable, 2> pawn_attack_table{
+    detail::make_step_attack_table(detail::black_pawn_steps),
+    detail::make_step_attack_table(detail::white_pawn_steps),
+};
+inline constexpr detail::SquarePairTable between_table = detail::make_between_table();
+inline constexpr detail::SquarePairTable line_table = detail::make_line_table();
+
+[[nodiscard]] constexpr BitBoard knight_attacks(const Square square) noexcept
+{
+    return knight_attack_table[square];
+}
+
+[[nodiscard]] constexpr BitBoard king_attacks(const Square square) noexcept
+{
+    return king_attack_table[square];
+}
+
+[[nodiscard]] constexpr BitBoard pawn_attacks(const PieceColor color, const Square square) noexcept
+{
+    return pawn_attack_table[static_cast<int>(color)][square];
+}
+
+// Squares strictly between two squares on a shared rank, file or diagonal; empty if they share none or are
+// neighbours.
+[[nodiscard]] constexpr BitBoard squares_between(const Square from, const Square to) noexcept
+{
+    return between_table[from][to];
+}
+
+// The whole rank, file or diagonal through two squares, edge to edge; empty if they share none.
+[[nodiscard]] constexpr BitBoard line_through(const Square from, const Square to) noexcept
+{
+    return line_table[from][to];
+}
+
+// Every square attacked by any of the knights at once.
+[[nodiscard]] constexpr BitBoard knight_attacks_of(const BitBoard knights) noexcept
+{
+    using namespace detail;
+    const auto bits = knights.to_ullong();
+    return BitBoard{
+        ((bits << 17 | bits >> 15) & ~file_0) | ((bits << 15 | bits >> 17) & ~file_7) |
+        ((bits << 10 | bits >> 6) & ~(file_0 | file_1)) | ((bits << 6 | bits >> 10) & ~(file_6 | file_7))
+    };
+}
+
+// Every square attacked by any of the sliders at once, for a whole side instead of one lookup per piece. Kogge-Stone
+// occluded fills run the eight directions over the whole set, as two four-lane vectors when AVX2 is available.
+[[nodiscard]] BitBoard
+slider_attacks_of(BitBoard orthogonal_sliders, BitBoard diagonal_sliders, BitBoard occupied) noexcept;
+
+// Sliding piece attacks looked up from fancy magic bitboard tables (PEXT-indexed when BMI2 is available). The
+// tables are built once during static initialization and must not be used by other static initializers.
+class SlidingAttackTable
+{
+  public:
+    enum class Slider
+    {
+        bishop,
+        rook,
+    };
+
+    explicit SlidingAttackTable(Slider slider);
+
+    [[nodiscard]] BitBoard attacks(const Square square, const BitBoard occupied) const noexcept
+    {
+        const auto& entry = entries_[square];
+        return BitBoard{attacks_[entry.offset + entry.index(occupied.to_ullong())]};
+    }
+
+  private:
+    struct Entry
+    {
+        std::uint64_t mask;
+        std::uint64_t magic;
+        std::uint32_t offset;
+        std::uint32_t shift;
+
+        [[nodiscard]] std::size_t index(const std::uint64_t occupied) const noexcept
+        {
+#if defined(__BMI2__)
+            return _pext_u64(occupied, mask);
+#else
+            return ((occupied & mask) * magic) >> shift;
+#endif
+        }
+    };
+
+    std::array<Entry, square_count> entries_{};
+    std::vector<std::uint64_t> attacks_;
+};
+
+extern const SlidingAttackTable bishop_attack_table;
+extern const SlidingAttackTable rook_attack_table;
+
+[[nodiscard]] inline BitBoard bishop_attacks(const Square square, const BitBoard occupied) noexcept
+{
+    return bishop_attack_table.attacks(square, occupied);
+}
+
+[[nodiscard]] inline BitBoard rook_attacks(const Square square, const BitBoard occupied) noexcept
+{
+    return rook_attack_table.attacks(square, occupied);
+}
+
+[[nodiscard]] inline BitBoard queen_attacks(const Square square, const BitBoard occupied) noexcept
+{
+    return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+}
+
+} // namespace chess
+
+// iterators hold their own copy of the bits, so they stay valid after the range is gone
+template <>
+inline constexpr bool std::ranges::enable_borrowed_range<chess::SquareRange> = true;
@@ -0,0 +1,160 @@
+#include "game.h"
+#include "mate_solver.h"
+#include "perft.h"
+#include "search.h"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <string_view>
+
+using namespace chess;
+
+namespace {
+
+constexpr int default_depth = 7;
+constexpr std::array thread_counts{1, 2, 4, 8, 16};
+constexpr int default_mate_rounds = 100;
+constexpr std::string_view usage = "usage: ChessBench [depth] [hash MB]\n"
+                                   "       time to depth of the search on the perft positions at 1 to 16 threads\n"
+                                   "       ChessBench --mate [rounds]\n"
+                                   "       time to solve a batch of mate puzzles under the default solver limits\n";
+
+struct MatePuzzle
+{
+    std::string_view name;
+    std::string_view fen;
+};
+
+constexpr std::array mate_puzzles{
+    MatePuzzle{"back rank mate in 1", "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"},
+    MatePuzzle{"scholar's mate in 1", "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4"},
+    MatePuzzle{"fool's mate in 1", "rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq - 0 2"},
+    MatePuzzle{"Morphy's mate in 2", "kbK5/pp6/1P6/8/8/8/8/R7 w - - 0 1"},
+    MatePuzzle{"Legal's mate in 2", "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1"},
+    MatePuzzle{"mate in 2", "r1b2k1r/ppp1bppp/8/1B1Q4/5q2/2P5/PPP2PPP/R3R1K1 w - - 1 1"},
+    MatePuzzle{"mate in 2", "6k1/pp4p1/2p5/2bp4/8/P5Pb/1P3rrP/2BRRN1K b - - 0 1"},
+    MatePuzzle{"mate in 3", "r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1"},
+    MatePuzzle{"mate in 3", "2r3k1/p4p2/3Rp2p/1p2P1pK/8/1P4P1/P3Q2P/1q6 b - - 0 1"},
+    MatePuzzle{"Philidor's mate in 4", "r6k/6pp/8/6N1/8/1Q6/8/6K1 w - - 0 1"},
+};
+
+struct BenchResult
+{
+    SearchReport::Duration time_to_depth{};
+    std::uint64_t nodes{0};
+    std::uint64_t beta_cutoffs{0};
+    std::uint64_t first_move_cutoffs{0};
+    double effective_branching_factor_sum{0.0};
+};
+
+BenchResult run_threads(const int thread_count, const int depth, const std::size_t hash_size_mb)
+{
+    BenchResult total;
+    for (const auto& reference : perft_reference_positions) {
+        auto search = Search{{.max_depth = depth}, thread_count, hash_size_mb};
+        const auto report = search.run(GameBoard::from_fen(reference.fen));
+        total.time_to_depth += report.elapsed;
+        total.nodes += report.nodes;
+        total.beta_cutoffs += report.beta_cutoffs;
+        total.first_move_cutoffs += report.first_move_cutoffs;
+        total.effective_branching_factor_sum += report.effective_branching_factor;
+    }
+    return total;
+}
+
+int run_bench(const int depth, const std::size_t hash_size_mb)
+{
+    fmt::print("depth {} over {} positions\n", depth, perft_reference_positions.size());
+    fmt::print(
+        "{:>8} {:>12} {:>14} {:>14} {:>8} {:>12} {:>6}\n",
+        "threads",
+        "time (ms)",
+        "nodes",
+        "nodes/sec",
+        "speedup",
+        "first cutoff",
+        "EBF"
+    );
+    SearchReport::Duration single_thread_time{};
+    for (const auto thread_count : thread_counts) {
+        const auto result = run_threads(thread_count, depth, hash_size_mb);
+        if (thread_count == 1) {
+            single_thread_time = result.time_to_depth;
+        }
+        const auto seconds = std::chrono::duration<double>(result.time_to_depth).count();
+        const auto first_move_cutoff_rate =
+            (result.beta_cutoffs > 0)
+                ? static_cast<double>(result.first_move_cutoffs) / static_cast<double>(result.beta_cutoffs)
+                : 0.0;
+        fmt::print(
+            "{:>8} {:>12} {:>14} {:>14.0f} {:>8.2f} {:>11.1f}% {:>6.2f}\n",
+            thread_count,
+            std::chrono::duration_cast<std::chrono::milliseconds>(result.time_to_depth).count(),
+            result.nodes,
+            (seconds > 0.0) ? static_cast<double>(result.nodes) / seconds : 0.0,
+            std::chrono::duration<double>(single_thread_time) / result.time_to_depth,
+            100.0 * first_move_cutoff_rate,
+            result.effective_branching_factor_sum / static_cast<double>(perft_reference_positions.size())
+        );
+    }
+    return EXIT_SUCCESS;
+}
+
+int run_mate_bench(const int rounds)
+{
+    // one solver for the whole batch, as a puzzle checker would use it
+    auto solver = MateSolver{};
+    int mates = 0;
+    std::uint64_t nodes = 0;
+    MateSolverResult::Duration elapsed{};
+    for (int round = 0; round < rounds; ++round) {
+        for (const auto& puzzle : mate_puzzles) {
+            const auto result = solver.solve(GameBoard::from_fen(puzzle.fen));
+            if (round == 0 && result.outcome != MateSolverResult::Outcome::mate) {
+                fmt::print(stderr, "no mate found in {}\n", puzzle.name);
+            }
+            mates += (result.outcome == MateSolverResult::Outcome::mate);
+            nodes += result.nodes;
+            elapsed += result.elapsed;
+        }
+    }
+    const auto count = rounds * static_cast<int>(mate_puzzles.size());
+    const auto minutes = std::chrono::duration<double, std::ratio<60>>(elapsed).count();
+    fmt::print(
+        "{} of {} puzzles mated in {} ms, {:.0f} puzzles/min, {:.0f} nodes/puzzle\n",
+        mates,
+        count,
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+        (minutes > 0.0) ? static_cast<double>(count) / minutes : 0.0,
+        (count > 0) ? static_cast<double>(nodes) / count : 0.0
+    );
+    return (mates == count) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try {
+        if (argc >= 2 && (std::string_view{argv[1]} == "-h" || std::string_view{argv[1]} == "--help")) {
+            fmt::print("{}", usage);
+            return EXIT_SUCCESS;
+        }
+        if (argc >= 2 && std::string_view{argv[1]} == "--mate") {
+            return run_mate_bench((argc >= 3) ? std::stoi(argv[2]) : default_mate_rounds);
+        }
+        const auto depth = (argc >= 2) ? std::stoi(argv[1]) : default_depth;
+        const auto hash_size_mb =
+            (argc >= 3) ? std::stoul(argv[2]) : std::size_t{TranspositionTable::default_size_mb * 4};
+        return run_bench(depth, hash_size_mb);
+    } catch (const std::exception& error) {
+        fmt::print(stderr, "error: {}\n", error.what());
+        return EXIT_FAILURE;
+    }
+}
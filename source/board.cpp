@@ -35,13 +35,11 @@ BoardPieces BoardPieces::make_standard_setup_board()
 
 std::optional<Piece> BoardPieces::at(const BitBoard position) const noexcept
 {
-    const auto piece_color = color_at(position);
-    const auto piece_type = type_at(position);
-    if (!piece_color.has_value() || !piece_type.has_value()) {
+    const auto code = mailbox_[to_square(position)];
+    if (code == no_piece_code) {
         return {};
     }
-    assert(piece_color.has_value() && piece_type.has_value() && "inconsistent bitboards");
-    return Piece{.color = *piece_color, .type = *piece_type};
+    return Piece{.color = piece_code_color(code), .type = piece_code_type(code)};
 }
 
 std::optional<Piece> BoardPieces::at(const Position& position) const
@@ -65,10 +63,8 @@ Piece BoardPieces::at_checked(const Position& position) const
 
 std::optional<PieceColor> BoardPieces::color_at(const BitBoard position) const noexcept
 {
-    assert(position.has_single_position());
-    return (black_.test_all(position))   ? std::optional<PieceColor>{PieceColor::black}
-           : (white_.test_all(position)) ? std::optional<PieceColor>{PieceColor::white}
-                                         : std::nullopt;
+    const auto code = mailbox_[to_square(position)];
+    return (code == no_piece_code) ? std::nullopt : std::optional{piece_code_color(code)};
 }
 
 std::optional<PieceColor> BoardPieces::color_at(const Position& position) const
@@ -78,14 +74,8 @@ std::optional<PieceColor> BoardPieces::color_at(const Position& position) const
 
 std::optional<PieceType> BoardPieces::type_at(const BitBoard position) const noexcept
 {
-    assert(position.has_single_position());
-    return (pawns_.test_all(position))     ? std::optional<PieceType>{PieceType::pawn}
-           : (knights_.test_all(position)) ? std::optional<PieceType>{PieceType::knight}
-           : (bishops_.test_all(position)) ? std::optional<PieceType>{PieceType::bishop}
-           : (rooks_.test_all(position))   ? std::optional<PieceType>{PieceType::rook}
-           : (queens_.test_all(position))  ? std::optional<PieceType>{PieceType::queen}
-           : (kings_.test_all(position))   ? std::optional<PieceType>{PieceType::king}
-                                           : std::nullopt;
+    const auto code = mailbox_[to_square(position)];
+    return (code == no_piece_code) ? std::nullopt : std::optional{piece_code_type(code)};
 }
 
 std::optional<PieceType> BoardPieces::type_at(const Position& position) const
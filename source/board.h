@@ -1,9 +1,15 @@
 #pragma once
 
+#include "attacks.h"
 #include "bit_board.h"
+#include "piece_square_tables.h"
 #include "pieces.h"
 #include "vec2.h"
 
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <set>
 #include <utility>
@@ -172,16 +178,34 @@ class BoardPieces
     [[nodiscard]] std::optional<PieceType> type_at(BitBoard position) const noexcept;
     [[nodiscard]] std::optional<PieceType> type_at(const Position& position) const;
 
+    // Evaluation terms kept up to date as pieces are set, cleared and moved, so reading them needs no board scan.
+    [[nodiscard]] Score material(const PieceColor color) const noexcept
+    {
+        return material_[static_cast<std::size_t>(color)];
+    }
+    // piece-square table bonuses, not counting material
+    [[nodiscard]] TaperedScore positional_score(const PieceColor color) const noexcept
+    {
+        return positional_[static_cast<std::size_t>(color)];
+    }
+    // max_phase in the starting position, falling towards 0 as pieces come off; promotions can take it above
+    [[nodiscard]] int phase() const noexcept
+    {
+        return phase_;
+    }
+
     template <Piece Piece>
     void clear(const BitBoard board) noexcept
     {
         of<Piece.color>().clear(board);
         of<Piece.type>().clear(board);
+        fill_mailbox(board, no_piece_code);
     }
     void clear(const Piece piece, const BitBoard board) noexcept
     {
         of(piece.color).clear(board);
         of(piece.type).clear(board);
+        fill_mailbox(board, no_piece_code);
     }
     void clear(const Position& position)
     {
@@ -198,6 +222,7 @@ class BoardPieces
         rooks_.clear(board);
         queens_.clear(board);
         kings_.clear(board);
+        fill_mailbox(board, no_piece_code);
     }
 
     template <Piece Piece>
@@ -206,6 +231,7 @@ class BoardPieces
         clear(positions);
         of<Piece.type>().set(positions);
         of<Piece.color>().set(positions);
+        fill_mailbox(positions, piece_code(Piece));
     }
     template <Piece Piece>
     void set(const Position& position)
@@ -218,6 +244,7 @@ class BoardPieces
         clear(positions);
         of(piece.type).set(positions);
         of(piece.color).set(positions);
+        fill_mailbox(positions, piece_code(piece));
     }
     void set(const Piece piece, const Position& position)
     {
@@ -228,16 +255,20 @@ class BoardPieces
     void move(const BitBoardMove move)
     {
         assert(at_checked(move.from) == Piece);
-        clear<Piece>(move.from);
-        set<Piece>(move.to);
+        clear_captured(move.to);
+        of<Piece.color>().clear(move.from).set(move.to);
+        of<Piece.type>().clear(move.from).set(move.to);
+        move_in_mailbox(Piece, to_square(move.from), to_square(move.to));
         assert(!at(move.from).has_value());
         assert(at_checked(move.to) == Piece);
     }
     void move(const Piece piece, const BitBoardMove move)
     {
         assert(at_checked(move.from) == piece);
-        clear(piece, move.from);
-        set(piece, move.to);
+        clear_captured(move.to);
+        of(piece.color).clear(move.from).set(move.to);
+        of(piece.type).clear(move.from).set(move.to);
+        move_in_mailbox(piece, to_square(move.from), to_square(move.to));
         assert(!at(move.from).has_value());
         assert(at_checked(move.to) == piece);
     }
@@ -267,6 +298,78 @@ class BoardPieces
     }
 
   private:
+    // 0 for an empty square, otherwise the piece type plus one in the low three bits and the color above them
+    using PieceCode = std::uint8_t;
+    static constexpr PieceCode no_piece_code{0};
+    static constexpr int piece_code_color_shift{3};
+    static constexpr PieceCode piece_code_type_mask{0b111};
+
+    [[nodiscard]] static constexpr PieceCode piece_code(const Piece piece) noexcept
+    {
+        return static_cast<PieceCode>(
+            (static_cast<int>(piece.color) << piece_code_color_shift) | (static_cast<int>(piece.type) + 1)
+        );
+    }
+    [[nodiscard]] static constexpr PieceColor piece_code_color(const PieceCode code) noexcept
+    {
+        return static_cast<PieceColor>(code >> piece_code_color_shift);
+    }
+    [[nodiscard]] static constexpr PieceType piece_code_type(const PieceCode code) noexcept
+    {
+        return static_cast<PieceType>((code & piece_code_type_mask) - 1);
+    }
+
+    // removes whatever piece the mailbox holds on a single square without touching the other bitboards
+    void clear_captured(const BitBoard position) noexcept
+    {
+        const auto square = to_square(position);
+        const auto code = mailbox_[square];
+        if (code != no_piece_code) {
+            of(piece_code_color(code)).clear(position);
+            of(piece_code_type(code)).clear(position);
+            remove_terms(code, square);
+        }
+    }
+
+    // replaces the occupant of each square in the mailbox and the evaluation terms
+    void fill_mailbox(const BitBoard positions, const PieceCode code) noexcept
+    {
+        for (const auto square : squares(positions)) {
+            if (mailbox_[square] != no_piece_code) {
+                remove_terms(mailbox_[square], square);
+            }
+            if (code != no_piece_code) {
+                add_terms(code, square);
+            }
+            mailbox_[square] = code;
+        }
+    }
+
+    // the destination must already be empty in the mailbox
+    void move_in_mailbox(const Piece piece, const Square from, const Square to) noexcept
+    {
+        mailbox_[from] = no_piece_code;
+        mailbox_[to] = piece_code(piece);
+        auto& positional = positional_[static_cast<std::size_t>(piece.color)];
+        positional -= piece_square_score(piece, from);
+        positional += piece_square_score(piece, to);
+    }
+
+    void add_terms(const PieceCode code, const Square square) noexcept
+    {
+        const auto piece = Piece{piece_code_color(code), piece_code_type(code)};
+        material_[static_cast<std::size_t>(piece.color)] += piece_value(piece.type);
+        positional_[static_cast<std::size_t>(piece.color)] += piece_square_score(piece, square);
+        phase_ += phase_weight(piece.type);
+    }
+    void remove_terms(const PieceCode code, const Square square) noexcept
+    {
+        const auto piece = Piece{piece_code_color(code), piece_code_type(code)};
+        material_[static_cast<std::size_t>(piece.color)] -= piece_value(piece.type);
+        positional_[static_cast<std::size_t>(piece.color)] -= piece_square_score(piece, square);
+        phase_ -= phase_weight(piece.type);
+    }
+
     BitBoard pawns_;
     BitBoard knights_;
     BitBoard bishops_;
@@ -275,6 +378,12 @@ class BoardPieces
     BitBoard kings_;
     BitBoard black_;
     BitBoard white_;
+    // the piece on each square indexed by Square, kept in step with the bitboards so lookups are a single load
+    std::array<PieceCode, square_count> mailbox_{};
+    // indexed by PieceColor
+    std::array<Score, 2> material_{};
+    std::array<TaperedScore, 2> positional_{};
+    int phase_{0};
 
     template <PieceColor Color>
     constexpr BitBoard& of()
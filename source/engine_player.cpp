@@ -0,0 +1,20 @@
+#include "engine_player.h"
+
+#include "game.h"
+#include "move.h"
+#include "search.h"
+
+#include <stdexcept>
+
+namespace chess {
+
+Move EnginePlayer::select_move(const GameBoard& board)
+{
+    last_report_ = search_.run(board);
+    if (last_report_.best_move == Move{}) {
+        throw std::invalid_argument("no legal move to select");
+    }
+    return last_report_.best_move;
+}
+
+} // namespace chess
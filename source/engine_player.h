@@ -0,0 +1,56 @@
+#pragma once
+
+#include "game.h"
+#include "move.h"
+#include "nnue.h"
+#include "player.h"
+#include "search.h"
+
+#include <memory>
+#include <utility>
+
+namespace chess {
+
+class EnginePlayer : public Player
+{
+  public:
+    explicit EnginePlayer(SearchLimits limits = default_limits(), const int thread_count = 1)
+        : search_{limits, thread_count}
+    {}
+
+    // a sub-second think time
+    [[nodiscard]] static SearchLimits default_limits() noexcept
+    {
+        return {.max_time = std::chrono::milliseconds{500}};
+    }
+
+    [[nodiscard]] Move select_move(const GameBoard& board) override;
+
+    // null goes back to the hand-written evaluation; not while a move is being selected
+    void set_nnue_network(std::shared_ptr<const NnueNetwork> network) noexcept
+    {
+        search_.set_nnue_network(std::move(network));
+    }
+
+    // may be called from another thread to end the current search early, or before it starts to skip it
+    void stop() noexcept
+    {
+        search_.stop();
+    }
+    // call before handing select_move() to another thread
+    void reset_stop() noexcept
+    {
+        search_.reset_stop();
+    }
+
+    [[nodiscard]] const SearchReport& last_report() const noexcept
+    {
+        return last_report_;
+    }
+
+  private:
+    Search search_;
+    SearchReport last_report_;
+};
+
+} // namespace chess
@@ -0,0 +1,23 @@
+#include "evaluation.h"
+
+#include "board.h"
+#include "game.h"
+#include "piece_square_tables.h"
+#include "pieces.h"
+
+#include <algorithm>
+
+namespace chess {
+
+Score evaluate(const GameBoard& board)
+{
+    const auto& pieces = board.pieces();
+    const auto own = board.active_color();
+    const auto opponent = board.inactive_color();
+    const auto positional = pieces.positional_score(own) - pieces.positional_score(opponent);
+    const auto phase = std::min(pieces.phase(), max_phase);
+    const auto tapered = (positional.opening * phase + positional.endgame * (max_phase - phase)) / max_phase;
+    return pieces.material(own) - pieces.material(opponent) + tapered;
+}
+
+} // namespace chess
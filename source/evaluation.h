@@ -0,0 +1,25 @@
+#pragma once
+
+#include "game.h"
+#include "piece_square_tables.h"
+#include "pieces.h"
+
+namespace chess {
+
+inline constexpr Score draw_score = 0;
+inline constexpr Score mate_score = 30'000;
+inline constexpr Score infinite_score = 32'000;
+// deepest ply a search can reach, so scores beyond mate_score - max_search_ply are mates
+inline constexpr int max_search_ply = 128;
+
+[[nodiscard]] constexpr bool is_mate_score(const Score score) noexcept
+{
+    return score >= mate_score - max_search_ply || score <= -mate_score + max_search_ply;
+}
+
+// Static evaluation of a position that is not checkmate or stalemate: material plus piece-square bonuses blended
+// between their opening and endgame values by the game phase. Reads the totals BoardPieces keeps, so it costs the
+// same whatever the position.
+[[nodiscard]] Score evaluate(const GameBoard& board);
+
+} // namespace chess
@@ -1,150 +1,423 @@
 #include "game.h"
+#include "attacks.h"
 #include "bit_board.h"
 #include "pieces.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <optional>
+#include <stdexcept>
+#include <string_view>
 
 namespace chess {
 
-std::optional<Piece> GameBoard::piece_at(const Position position) const
-{
-    return pieces_.at(position);
+namespace {
+
+std::optional<PieceType> piece_type_from_fen_char(const char c)
+{
+    switch (c) {
+    case 'p':
+        return PieceType::pawn;
+    case 'n':
+        return PieceType::knight;
+    case 'b':
+        return PieceType::bishop;
+    case 'r':
+        return PieceType::rook;
+    case 'q':
+        return PieceType::queen;
+    case 'k':
+        return PieceType::king;
+    default:
+        return std::nullopt;
+    }
 }
 
-void GameBoard::update_en_passant_state(const Piece piece, const BitBoardMove move)
+std::string_view next_fen_field(std::string_view& fen)
 {
-    en_passant_square_.clear_all();
-    if (piece.type == PieceType::pawn) {
-        const auto from_position = move.from.to_position();
-        const auto to_position = move.to.to_position();
-        if (Position::chebyshev_distance(from_position, to_position) == 2) {
-            en_passant_square_.set((from_position + to_position) / 2);
-        }
+    const auto field_begin = fen.find_first_not_of(' ');
+    if (field_begin == std::string_view::npos) {
+        fen = {};
+        return {};
     }
+    fen.remove_prefix(field_begin);
+    const auto field_end = std::min(fen.find(' '), fen.size());
+    const auto field = fen.substr(0, field_end);
+    fen.remove_prefix(field_end);
+    return field;
 }
 
-void GameBoard::update_castling_state(const BitBoardMove move)
+// in the order generators emit them
+constexpr std::array<PieceType, 4> promotion_types{
+    PieceType::queen,
+    PieceType::rook,
+    PieceType::bishop,
+    PieceType::knight,
+};
+
+// moves every bit by a square index offset, up the board for positive offsets
+constexpr std::uint64_t shift_squares(const std::uint64_t bits, const int offset) noexcept
+{
+    return (offset >= 0) ? bits << offset : bits >> -offset;
+}
+
+} // namespace
+
+GameBoard GameBoard::from_fen(std::string_view fen)
 {
-    if (move.from == GameBoard::black_queenside_rook_position) {
-        black_queenside_castle_piece_moved_ = true;
+    const auto placement = next_fen_field(fen);
+    const auto active_color = next_fen_field(fen);
+    const auto castling = next_fen_field(fen);
+    const auto en_passant = next_fen_field(fen);
+    if (placement.empty() || active_color.empty() || castling.empty() || en_passant.empty()) {
+        throw std::invalid_argument("incomplete FEN string");
     }
-    if (move.from == GameBoard::black_kingside_rook_position) {
-        black_kingside_castle_piece_moved_ = true;
+
+    GameBoard board;
+    board.pieces_ = BoardPieces{};
+    Position::dimension_type row = 0;
+    Position::dimension_type column = 0;
+    for (const char c : placement) {
+        if (c == '/') {
+            if (column != static_cast<Position::dimension_type>(BitBoard::board_size)) {
+                throw std::invalid_argument("invalid FEN rank length");
+            }
+            ++row;
+            column = 0;
+        } else if (c >= '1' && c <= '8') {
+            column += c - '0';
+        } else {
+            const auto lower = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            const auto type = piece_type_from_fen_char(lower);
+            if (!type.has_value() || row >= static_cast<Position::dimension_type>(BitBoard::board_size) ||
+                column >= static_cast<Position::dimension_type>(BitBoard::board_size)) {
+                throw std::invalid_argument("invalid FEN piece placement");
+            }
+            const auto color = (lower == c) ? PieceColor::black : PieceColor::white;
+            board.pieces_.set({color, *type}, Position{row, column});
+            ++column;
+        }
     }
-    if (move.from == GameBoard::black_king_position) {
-        black_queenside_castle_piece_moved_ = true;
-        black_kingside_castle_piece_moved_ = true;
+    if (row != static_cast<Position::dimension_type>(BitBoard::board_size) - 1 ||
+        column != static_cast<Position::dimension_type>(BitBoard::board_size)) {
+        throw std::invalid_argument("invalid FEN piece placement");
     }
-    if (move.from == GameBoard::white_queenside_rook_position) {
-        white_queenside_castle_piece_moved_ = true;
+
+    if (active_color == "w") {
+        board.active_color_ = PieceColor::white;
+    } else if (active_color == "b") {
+        board.active_color_ = PieceColor::black;
+    } else {
+        throw std::invalid_argument("invalid FEN active color");
     }
-    if (move.from == GameBoard::white_kingside_rook_position) {
-        white_kingside_castle_piece_moved_ = true;
+
+    board.castling_rights_ = 0;
+    for (const char c : castling) {
+        switch (c) {
+        case 'K':
+            board.castling_rights_ |= white_kingside_castling;
+            break;
+        case 'Q':
+            board.castling_rights_ |= white_queenside_castling;
+            break;
+        case 'k':
+            board.castling_rights_ |= black_kingside_castling;
+            break;
+        case 'q':
+            board.castling_rights_ |= black_queenside_castling;
+            break;
+        case '-':
+            break;
+        default:
+            throw std::invalid_argument("invalid FEN castling availability");
+        }
     }
-    if (move.from == GameBoard::white_king_position) {
-        white_queenside_castle_piece_moved_ = true;
-        white_kingside_castle_piece_moved_ = true;
+
+    if (en_passant != "-") {
+        if (en_passant.size() != 2 || en_passant[0] < 'a' || en_passant[0] > 'h' || en_passant[1] < '1' ||
+            en_passant[1] > '8') {
+            throw std::invalid_argument("invalid FEN en passant square");
+        }
+        board.en_passant_square_ = BitBoard{Position{'8' - en_passant[1], en_passant[0] - 'a'}};
+    }
+
+    // the move counters are optional; only the halfmove clock affects play
+    const auto halfmove_clock = next_fen_field(fen);
+    if (!halfmove_clock.empty()) {
+        const auto* const end = halfmove_clock.data() + halfmove_clock.size();
+        const auto [parsed_end, error] = std::from_chars(halfmove_clock.data(), end, board.halfmove_clock_);
+        if (error != std::errc{} || parsed_end != end) {
+            throw std::invalid_argument("invalid FEN halfmove clock");
+        }
     }
+
+    board.zobrist_key_ = board.compute_zobrist_key();
+    return board;
 }
 
-template <PieceColor Color>
-bool GameBoard::is_castling_move(BitBoardMove move) const
+std::optional<Piece> GameBoard::piece_at(const Position position) const
+{
+    return pieces_.at(position);
+}
+
+const BoardPieces& GameBoard::pieces() const
 {
-    return king_castling_moves<Color>().test(move.to);
+    return pieces_;
 }
 
-void GameBoard::white_castle(const BitBoardMove king_move)
+void GameBoard::update_castling_state(const BitBoardMove move)
 {
-    const auto white_moves = king_castling_moves<PieceColor::white>();
-    if ((white_moves & white_castle_kingside_king_move) == king_move.to) {
-        pieces_.move<pieces::white_rook>({white_kingside_rook_position, white_castle_kingside_rook_move});
+    // a king or rook leaving its square, or a rook being captured on it, forfeits that side
+    const auto touched = move.from | move.to;
+    if (touched.test_any(black_queenside_rook_position | black_king_position)) {
+        castling_rights_ &= ~black_queenside_castling;
+    }
+    if (touched.test_any(black_kingside_rook_position | black_king_position)) {
+        castling_rights_ &= ~black_kingside_castling;
     }
-    if ((white_moves & white_castle_queenside_king_move) == king_move.to) {
-        pieces_.move<pieces::white_rook>({white_queenside_rook_position, white_castle_queenside_rook_move});
+    if (touched.test_any(white_queenside_rook_position | white_king_position)) {
+        castling_rights_ &= ~white_queenside_castling;
+    }
+    if (touched.test_any(white_kingside_rook_position | white_king_position)) {
+        castling_rights_ &= ~white_kingside_castling;
     }
 }
 
-void GameBoard::black_castle(const BitBoardMove king_move)
+std::optional<GameBoard::BitBoardMove> GameBoard::castling_rook_move(const BitBoardMove king_move)
 {
-    const auto black_moves = king_castling_moves<PieceColor::black>();
-    if ((black_moves & black_castle_kingside_king_move) == king_move.to) {
-        pieces_.move<pieces::black_rook>({black_kingside_rook_position, black_castle_kingside_rook_move});
-    }
-    if ((black_moves & black_castle_queenside_king_move) == king_move.to) {
-        pieces_.move<pieces::black_rook>({black_queenside_rook_position, black_castle_queenside_rook_move});
+    if (king_move.from == black_king_position) {
+        if (king_move.to == black_castle_kingside_king_move) {
+            return BitBoardMove{black_kingside_rook_position, black_castle_kingside_rook_move};
+        }
+        if (king_move.to == black_castle_queenside_king_move) {
+            return BitBoardMove{black_queenside_rook_position, black_castle_queenside_rook_move};
+        }
+    } else if (king_move.from == white_king_position) {
+        if (king_move.to == white_castle_kingside_king_move) {
+            return BitBoardMove{white_kingside_rook_position, white_castle_kingside_rook_move};
+        }
+        if (king_move.to == white_castle_queenside_king_move) {
+            return BitBoardMove{white_queenside_rook_position, white_castle_queenside_rook_move};
+        }
     }
+    return std::nullopt;
 }
 
-void GameBoard::castle(const Piece piece, const BitBoardMove king_move)
+Move GameBoard::encode_move(const PositionMove move, const std::optional<PieceType> promotion_selection) const
 {
-    switch (piece.color) {
-    case PieceColor::black:
-        black_castle(king_move);
-    case PieceColor::white:
-        white_castle(king_move);
-        break;
+    const auto from = BitBoard{move.from};
+    const auto to = BitBoard{move.to};
+    if (from == to) {
+        throw std::invalid_argument("move.from == move.to");
+    }
+    const auto piece = pieces_.at_checked(from);
+    const bool is_capture = inactive_color_board().test_any(to);
+
+    if (promotion_selection.has_value()) {
+        if (*promotion_selection == PieceType::pawn || *promotion_selection == PieceType::king) {
+            throw std::invalid_argument("invalid promotion selection");
+        }
+        return Move::make_promotion(to_square(from), to_square(to), *promotion_selection, is_capture);
     }
+
+    auto flags = is_capture ? Move::capture : Move::quiet;
+    if (piece.type == PieceType::pawn) {
+        if (en_passant_square_.test_any(to)) {
+            flags = Move::en_passant_capture;
+        } else if (Position::chebyshev_distance(move.from, move.to) == 2) {
+            flags = Move::double_pawn_push;
+        }
+    } else if (piece.type == PieceType::king && castling_rook_move({from, to}).has_value()) {
+        flags = (to == black_castle_kingside_king_move || to == white_castle_kingside_king_move)
+                    ? Move::kingside_castle
+                    : Move::queenside_castle;
+    }
+    return Move{to_square(from), to_square(to), flags};
 }
 
-void GameBoard::make_move(const Move move, std::optional<PieceType> promotion_selection)
+ZobristKey GameBoard::compute_zobrist_key() const
 {
-    make_move({BitBoard{move.from}, BitBoard{move.to}}, promotion_selection);
+    ZobristKey key = zobrist_keys.castling_rights[castling_rights_];
+    for (const auto square : squares(occupied())) {
+        key ^= zobrist_piece_key(pieces_.at_checked(to_bitboard(square)), square);
+    }
+    if (!en_passant_square_.empty()) {
+        key ^= zobrist_en_passant_key(to_square(en_passant_square_));
+    }
+    if (active_color_ == PieceColor::black) {
+        key ^= zobrist_keys.black_to_move;
+    }
+    return key;
 }
 
-void GameBoard::make_move(const BitBoardMove move, std::optional<PieceType> promotion_selection)
+void GameBoard::make_move(const PositionMove move, std::optional<PieceType> promotion_selection)
 {
-    make_move(pieces_.at_checked(move.from), move, promotion_selection);
+    make_move(encode_move(move, promotion_selection));
 }
 
-void GameBoard::make_move(const Piece piece, const BitBoardMove move, std::optional<PieceType> promotion_selection)
+void GameBoard::make_move(const Move move)
 {
-    assert(move.from.count() == 1U);
-    assert(move.to.count() == 1U);
-    if (move.from == move.to) {
-        throw std::invalid_argument("move.from == move.to");
+    if (active_color_ == PieceColor::black) {
+        make_move<PieceColor::black>(move);
+    } else {
+        make_move<PieceColor::white>(move);
     }
-    if (promotion_selection.has_value()) {
-        if (*promotion_selection == PieceType::pawn || *promotion_selection == PieceType::king) {
-            throw std::invalid_argument("invalid promotion selection");
-        }
-        history_.emplace_back(*this);
+}
 
-        pieces_.clear(piece, move.from);
-        pieces_.set({piece.color, *promotion_selection}, move.to);
+template <PieceColor Color>
+void GameBoard::make_move(const Move move)
+{
+    constexpr auto Opponent = opposite_color_v<Color>;
+    // a pawn pushed to the square behind an en passant capture stands this far from it
+    constexpr Square forward = (Color == PieceColor::white) ? 8 : -8;
+
+    const auto from = to_bitboard(move.from());
+    const auto to = to_bitboard(move.to());
+    const auto piece = pieces_.at_checked(from);
+    assert(piece.color == Color);
+    const Square captured_square = move.is_en_passant() ? en_passant_capture_square(move) : move.to();
+
+    history_.push_back({
+        .zobrist_key = zobrist_key_,
+        .captured = move.is_capture() ? pieces_.type_at(to_bitboard(captured_square)) : std::nullopt,
+        .move = move,
+        .halfmove_clock = halfmove_clock_,
+        .en_passant_square = en_passant_square_.empty() ? no_en_passant_square
+                                                        : static_cast<std::uint8_t>(to_square(en_passant_square_)),
+        .castling_rights = castling_rights_,
+    });
+    const auto& record = history_.back();
+    assert(!move.is_capture() || record.captured.has_value());
+    status_.reset();
 
-        active_color_ = opposite_color(active_color_);
+    auto key = zobrist_key_ ^ zobrist_piece_key(piece, move.from());
+    if (record.captured.has_value()) {
+        key ^= zobrist_piece_key({Opponent, *record.captured}, captured_square);
+    }
+    if (move.is_en_passant()) {
+        pieces_.clear<Piece{Opponent, PieceType::pawn}>(to_bitboard(captured_square));
+    }
+    if (move.is_promotion()) {
+        const auto promoted = Piece{Color, move.promotion_type()};
+        pieces_.clear<Piece{Color, PieceType::pawn}>(from);
+        pieces_.set(promoted, to);
+        key ^= zobrist_piece_key(promoted, move.to());
     } else {
-        history_.emplace_back(*this);
+        pieces_.move(piece, {from, to});
+        key ^= zobrist_piece_key(piece, move.to());
+    }
+    if (move.is_castling()) {
+        constexpr auto rook = Piece{Color, PieceType::rook};
+        const auto rook_move = castling_rook_move<Color>(move);
+        pieces_.move<rook>(rook_move);
+        key ^= zobrist_piece_key(rook, to_square(rook_move.from)) ^ zobrist_piece_key(rook, to_square(rook_move.to));
+    }
 
-        // en passant capture
-        if (piece.type == PieceType::pawn && en_passant_square_.test_any(move.to)) {
-            pieces_.clear({move.from.to_position().x(), move.to.to_position().y()});
-        }
+    if (!en_passant_square_.empty()) {
+        key ^= zobrist_en_passant_key(to_square(en_passant_square_));
+    }
+    en_passant_square_ = move.is_double_pawn_push() ? to_bitboard(move.from() + forward) : BitBoard{};
+    if (!en_passant_square_.empty()) {
+        key ^= zobrist_en_passant_key(to_square(en_passant_square_));
+    }
+    key ^= zobrist_keys.castling_rights[castling_rights_];
+    update_castling_state({from, to});
+    key ^= zobrist_keys.castling_rights[castling_rights_];
 
-        // castling move
-        if (piece.type == PieceType::king) {
-            castle(piece, move);
-        }
+    const bool is_irreversible = move.is_capture() || piece.type == PieceType::pawn;
+    halfmove_clock_ = is_irreversible ? 0 : halfmove_clock_ + 1;
+    active_color_ = Opponent;
+    zobrist_key_ = key ^ zobrist_keys.black_to_move;
+    assert(zobrist_key_ == compute_zobrist_key());
+}
 
-        // normal move
-        pieces_.move(piece, move);
+void GameBoard::unmake_move()
+{
+    assert(!history_.empty() && "no move to unmake");
+    const auto record = history_.back();
+    history_.pop_back();
+    status_.reset();
 
-        active_color_ = opposite_color(active_color_);
+    // the side that made the move is the one not to move now
+    if (active_color_ == PieceColor::black) {
+        unmake_move<PieceColor::white>(record);
+    } else {
+        unmake_move<PieceColor::black>(record);
+    }
+}
+
+template <PieceColor Color>
+void GameBoard::unmake_move(const UndoRecord& record)
+{
+    active_color_ = Color;
+    en_passant_square_ = (record.en_passant_square == no_en_passant_square) ? BitBoard{}
+                                                                             : to_bitboard(record.en_passant_square);
+    castling_rights_ = record.castling_rights;
+    halfmove_clock_ = record.halfmove_clock;
+    zobrist_key_ = record.zobrist_key;
+
+    const auto move = record.move;
+    const auto from = to_bitboard(move.from());
+    const auto to = to_bitboard(move.to());
+    const auto piece = pieces_.at_checked(to);
+    assert(piece.color == Color);
+    if (move.is_promotion()) {
+        pieces_.clear(piece, to);
+        pieces_.set<Piece{Color, PieceType::pawn}>(from);
+    } else {
+        pieces_.move(piece, {to, from});
+    }
+    if (move.is_castling()) {
+        const auto rook_move = castling_rook_move<Color>(move);
+        pieces_.move<Piece{Color, PieceType::rook}>({rook_move.to, rook_move.from});
+    }
 
-        update_en_passant_state(piece, move);
-        update_castling_state(move);
+    if (record.captured.has_value()) {
+        const auto captured_square = move.is_en_passant() ? to_bitboard(en_passant_capture_square(move)) : to;
+        pieces_.set({opposite_color_v<Color>, *record.captured}, captured_square);
     }
 }
 
-void GameBoard::undo_previous_move()
+GameBoard::PieceChanges GameBoard::last_move_changes() const
 {
-    set_state(history_.back());
-    history_.pop_back();
+    assert(!history_.empty() && "no move made");
+    const auto& record = history_.back();
+    const auto move = record.move;
+    const auto to = to_bitboard(move.to());
+    const auto placed = pieces_.at_checked(to);
+    const auto mover = move.is_promotion() ? Piece{placed.color, PieceType::pawn} : placed;
+
+    PieceChanges changes;
+    changes.removed[changes.removed_count++] = {mover, move.from()};
+    changes.added[changes.added_count++] = {placed, move.to()};
+    if (record.captured.has_value()) {
+        const Square captured_square = move.is_en_passant() ? en_passant_capture_square(move) : move.to();
+        changes.removed[changes.removed_count++] = {{opposite_color(placed.color), *record.captured}, captured_square};
+    }
+    if (move.is_castling()) {
+        const auto rook = Piece{placed.color, PieceType::rook};
+        const auto rook_move = *castling_rook_move({to_bitboard(move.from()), to});
+        changes.removed[changes.removed_count++] = {rook, to_square(rook_move.from)};
+        changes.added[changes.added_count++] = {rook, to_square(rook_move.to)};
+    }
+    return changes;
 }
 
-BitBoard GameBoard::attacked_by_color(const PieceColor color) const
+BitBoard GameBoard::attackers_to(const Square square, const BitBoard occupancy) const
 {
-    return (color == PieceColor::black) ? attacked_by<PieceColor::black>() : attacked_by<PieceColor::white>();
+    // a pawn attacks the square exactly when a pawn of the other colour on the square would attack it
+    const auto pawn_attackers = (pawn_attacks(PieceColor::white, square) & black()) |
+                                (pawn_attacks(PieceColor::black, square) & white());
+    const auto attackers = (pawn_attackers & pawns()) | (knight_attacks(square) & knights()) |
+                           (king_attacks(square) & kings()) |
+                           (bishop_attacks(square, occupancy) & (bishops() | queens())) |
+                           (rook_attacks(square, occupancy) & (rooks() | queens()));
+    return attackers & occupancy;
 }
 
 bool GameBoard::is_color_in_check(const PieceColor color) const
@@ -154,29 +427,72 @@ bool GameBoard::is_color_in_check(const PieceColor color) const
 
 bool GameBoard::is_active_in_check() const
 {
-    return is_color_in_check(active_color());
+    // the search asks this at every node, where working out the whole status would cost far more than it saves
+    return status_.has_value() ? status_->in_check : is_color_in_check(active_color());
 }
 
-bool GameBoard::test_move_for_self_check(const BitBoardMove& move) const
+bool GameBoard::is_in_checkmate() const
 {
-    GameBoard test_board{*this};
-    test_board.make_move(move);
-    return test_board.is_color_in_check(test_board.inactive_color());
+    return status().is_checkmate();
 }
 
-bool GameBoard::is_in_checkmate() const
+bool GameBoard::is_in_stalemate() const
 {
-    return is_color_in_check(active_color()) && !has_valid_move();
+    return status().is_stalemate();
 }
 
-bool GameBoard::is_in_stalemate() const
+const GameBoard::PositionStatus& GameBoard::status() const
 {
-    return !is_color_in_check(active_color()) && !has_valid_move();
+    if (!status_.has_value()) {
+        status_ = (active_color() == PieceColor::black) ? compute_status<PieceColor::black>()
+                                                        : compute_status<PieceColor::white>();
+    }
+    return *status_;
 }
 
 bool GameBoard::is_game_over() const
 {
-    return is_in_checkmate() || is_in_stalemate();
+    return is_in_checkmate() || is_in_stalemate() || is_draw_by_repetition() || is_draw_by_fifty_move_rule();
+}
+
+int GameBoard::repetition_count(const int stop_at) const
+{
+    // positions before the last capture, pawn move or (via the halfmove clock) FEN can never recur, and positions
+    // with the other side to move can't match, so only every other key back to the last irreversible move is checked
+    const auto plies = std::min<std::size_t>(halfmove_clock_, history_.size());
+    int count = 0;
+    for (std::size_t ply = 4; ply <= plies; ply += 2) {
+        if (history_[history_.size() - ply].zobrist_key == zobrist_key_ && ++count == stop_at) {
+            break;
+        }
+    }
+    return count;
+}
+
+bool GameBoard::is_repetition() const
+{
+    return repetition_count(1) >= 1;
+}
+
+bool GameBoard::is_draw_by_repetition() const
+{
+    return repetition_count(2) >= 2;
+}
+
+bool GameBoard::is_draw_by_fifty_move_rule() const
+{
+    static constexpr int fifty_moves_in_plies = 100;
+    return halfmove_clock_ >= fifty_moves_in_plies && !is_in_checkmate();
+}
+
+ZobristKey GameBoard::zobrist_key() const
+{
+    return zobrist_key_;
+}
+
+int GameBoard::halfmove_clock() const
+{
+    return halfmove_clock_;
 }
 
 GameBoard::Position GameBoard::active_king_position() const
@@ -184,143 +500,298 @@ GameBoard::Position GameBoard::active_king_position() const
     return (active_color_board() & kings()).to_position();
 }
 
-bool GameBoard::is_promotion_move(const Move move) const
+bool GameBoard::is_promotion_move(const PositionMove move) const
+{
+    return is_promotion_move(BitBoardMove::from_move(move));
+}
+
+bool GameBoard::is_promotion_move(const BitBoardMove move) const
 {
     const auto piece = pieces_.at_checked(move.from);
-    return (piece.color == PieceColor::black) ? is_promotion_move<PieceColor::black>(BitBoardMove::from_move(move))
-                                              : is_promotion_move<PieceColor::white>(BitBoardMove::from_move(move));
+    return (piece.color == PieceColor::black) ? is_promotion_move<PieceColor::black>(move)
+                                              : is_promotion_move<PieceColor::white>(move);
 }
 
 [[nodiscard]] BitBoard GameBoard::valid_moves_bitboard(BitBoard from) const
 {
-    return (active_color() == PieceColor::black) ? valid_moves_bitboard<PieceColor::black>(from)
-                                                 : valid_moves_bitboard<PieceColor::white>(from);
+    return status().legal_destinations[to_square(from)];
+}
+
+template <PieceColor Color, PieceType Type, GameBoard::MoveScope Scope>
+void GameBoard::add_legal_moves(MoveList& moves, const LegalMoveMasks& masks, const BitBoard pieces) const
+{
+    assert((pieces_.of<Piece{Color, Type}>().test_all(pieces)));
+    const auto opponent = pieces_.of<opposite_color_v<Color>>();
+    for (const auto from_square : squares(pieces)) {
+        const auto from = to_bitboard(from_square);
+        const auto destinations = legal_destinations<Color, Type, Scope>(from, masks);
+        for (const auto to_square : squares(destinations)) {
+            const auto to = to_bitboard(to_square);
+            const bool is_capture = opponent.test_any(to);
+            auto flags = is_capture ? Move::capture : Move::quiet;
+            if constexpr (Type == PieceType::pawn) {
+                if (piece_row<opposite_color_v<Color>>().test_any(to)) {
+                    for (const auto promotion : promotion_types) {
+                        moves.push_back(Move::make_promotion(from_square, to_square, promotion, is_capture));
+                    }
+                    continue;
+                }
+                if (en_passant_square_.test_any(to)) {
+                    flags = Move::en_passant_capture;
+                } else if (from_square - to_square == 16 || to_square - from_square == 16) {
+                    flags = Move::double_pawn_push;
+                }
+            } else if constexpr (Type == PieceType::king) {
+                if (to == castling_king_move<Color, CastlingSide::kingside>().to &&
+                    from == castling_king_move<Color, CastlingSide::kingside>().from) {
+                    flags = Move::kingside_castle;
+                } else if (to == castling_king_move<Color, CastlingSide::queenside>().to &&
+                           from == castling_king_move<Color, CastlingSide::queenside>().from) {
+                    flags = Move::queenside_castle;
+                }
+            }
+            moves.push_back(Move{from_square, to_square, flags});
+        }
+    }
+}
+
+template <PieceColor Color, GameBoard::MoveScope Scope>
+void GameBoard::add_pawn_moves(MoveList& moves, const LegalMoveMasks& masks) const
+{
+    constexpr auto Opponent = opposite_color_v<Color>;
+    // square index offsets of a push and of the captures towards file 0 and file 7
+    constexpr int push = (Color == PieceColor::white) ? 8 : -8;
+    constexpr int capture_to_file_0 = push - 1;
+    constexpr int capture_to_file_7 = push + 1;
+
+    // a pinned pawn can only move along its pin line, which the shifts below don't know about
+    const auto own_pawns = pieces_.of<Piece{Color, PieceType::pawn}>();
+    add_legal_moves<Color, PieceType::pawn, Scope>(moves, masks, own_pawns & masks.pinned);
+
+    const auto pawns = (own_pawns & ~masks.pinned).to_ullong();
+    const auto empty = ~occupied().to_ullong();
+    const auto evasions = masks.check_evasions.to_ullong();
+    const auto opponent = pieces_.of<Opponent>().to_ullong();
+    const auto promotion_rank = piece_row<Opponent>().to_ullong();
+    // pawns one push from their starting rank may push again
+    const auto second_push_rank = shift_squares(pawn_row<Color>().to_ullong(), push);
+
+    const auto single_pushes = shift_squares(pawns, push) & empty;
+    const auto pushes = single_pushes & evasions;
+    const auto double_pushes = shift_squares(single_pushes & second_push_rank, push) & empty & evasions;
+    const auto captures_to_file_0 = shift_squares(pawns, capture_to_file_0) & ~detail::file_7 & opponent & evasions;
+    const auto captures_to_file_7 = shift_squares(pawns, capture_to_file_7) & ~detail::file_0 & opponent & evasions;
+
+    const auto add_moves = [&moves](const std::uint64_t targets, const int offset, const Move::Flags flags) {
+        for (const auto to : squares(BitBoard{targets})) {
+            moves.push_back(Move{to - offset, to, flags});
+        }
+    };
+    const auto add_promotions = [&moves](const std::uint64_t targets, const int offset, const bool is_capture) {
+        for (const auto to : squares(BitBoard{targets})) {
+            for (const auto promotion : promotion_types) {
+                moves.push_back(Move::make_promotion(to - offset, to, promotion, is_capture));
+            }
+        }
+    };
+    if constexpr (Scope != MoveScope::quiets) {
+        add_promotions(pushes & promotion_rank, push, false);
+        add_promotions(captures_to_file_0 & promotion_rank, capture_to_file_0, true);
+        add_promotions(captures_to_file_7 & promotion_rank, capture_to_file_7, true);
+        add_moves(captures_to_file_0 & ~promotion_rank, capture_to_file_0, Move::capture);
+        add_moves(captures_to_file_7 & ~promotion_rank, capture_to_file_7, Move::capture);
+    }
+    if constexpr (Scope != MoveScope::captures_and_promotions) {
+        add_moves(pushes & ~promotion_rank, push, Move::quiet);
+        add_moves(double_pushes, 2 * push, Move::double_pawn_push);
+    }
+
+    if (Scope != MoveScope::quiets && !en_passant_square_.empty()) {
+        const auto target = to_square(en_passant_square_);
+        // the pawns that could capture onto the square are where an opposing pawn on it would attack
+        const auto capturers = pawn_attacks(Opponent, target) & BitBoard{pawns};
+        for (const auto from : squares(capturers)) {
+            if (is_legal_en_passant<Color>(to_bitboard(from))) {
+                moves.push_back(Move{from, target, Move::en_passant_capture});
+            }
+        }
+    }
 }
 
-std::vector<GameBoard::Position> GameBoard::valid_moves_vector(const Position from)
+template <PieceColor Color, GameBoard::MoveScope Scope>
+void GameBoard::generate_legal_moves(MoveList& moves, const LegalMoveMasks& masks) const
 {
-    return valid_moves_bitboard(BitBoard{from}).to_position_vector();
+    add_pawn_moves<Color, Scope>(moves, masks);
+    add_legal_moves<Color, PieceType::knight, Scope>(moves, masks, pieces_.of<Piece{Color, PieceType::knight}>());
+    add_legal_moves<Color, PieceType::bishop, Scope>(moves, masks, pieces_.of<Piece{Color, PieceType::bishop}>());
+    add_legal_moves<Color, PieceType::rook, Scope>(moves, masks, pieces_.of<Piece{Color, PieceType::rook}>());
+    add_legal_moves<Color, PieceType::queen, Scope>(moves, masks, pieces_.of<Piece{Color, PieceType::queen}>());
+    add_legal_moves<Color, PieceType::king, Scope>(moves, masks, pieces_.of<Piece{Color, PieceType::king}>());
 }
 
-std::set<GameBoard::Position> GameBoard::valid_moves_set(const Position from)
+void GameBoard::generate_legal_moves(MoveList& moves) const
 {
-    return valid_moves_bitboard(BitBoard{from}).to_position_set();
+    moves.clear();
+    if (active_color() == PieceColor::black) {
+        generate_legal_moves<PieceColor::black, MoveScope::all>(moves, legal_move_masks<PieceColor::black>());
+    } else {
+        generate_legal_moves<PieceColor::white, MoveScope::all>(moves, legal_move_masks<PieceColor::white>());
+    }
 }
 
-PieceColor GameBoard::active_color() const
+GameBoard::LegalMoveMasks GameBoard::legal_move_masks() const
 {
-    return active_color_;
+    return (active_color() == PieceColor::black) ? legal_move_masks<PieceColor::black>()
+                                                 : legal_move_masks<PieceColor::white>();
 }
 
-PieceColor GameBoard::inactive_color() const
+void GameBoard::generate_legal_captures(MoveList& moves) const
 {
-    return opposite_color(active_color_);
+    generate_legal_captures(moves, legal_move_masks());
 }
 
-bool GameBoard::is_active_piece(const Position& position) const
+void GameBoard::generate_legal_captures(MoveList& moves, const LegalMoveMasks& masks) const
 {
-    return active_color_board().test(position);
+    moves.clear();
+    if (active_color() == PieceColor::black) {
+        generate_legal_moves<PieceColor::black, MoveScope::captures_and_promotions>(moves, masks);
+    } else {
+        generate_legal_moves<PieceColor::white, MoveScope::captures_and_promotions>(moves, masks);
+    }
 }
 
-BitBoard GameBoard::knight_moves(const BitBoard from) const
+void GameBoard::generate_legal_quiets(MoveList& moves) const
 {
-    // 01010000
-    // 10001000
-    // 00000000
-    // 10001000
-    // 01010000
-    // 00000000
-    // 00000000
-    // 00000000
-    static constexpr BitBoard knight_moves_board{0x50'88'00'88'50'00'00'00};
-    static const Position knight_moves_origin{2, 2};
+    generate_legal_quiets(moves, legal_move_masks());
+}
 
-    assert(knights().test_all(from) && "not a knight");
-    const auto offset = from.to_position() - knight_moves_origin;
-    return BitBoard::shift(knight_moves_board, offset);
+void GameBoard::generate_legal_quiets(MoveList& moves, const LegalMoveMasks& masks) const
+{
+    moves.clear();
+    if (active_color() == PieceColor::black) {
+        generate_legal_moves<PieceColor::black, MoveScope::quiets>(moves, masks);
+    } else {
+        generate_legal_moves<PieceColor::white, MoveScope::quiets>(moves, masks);
+    }
 }
 
-BitBoard GameBoard::bishop_moves(const BitBoard from) const
+template <PieceColor Color>
+bool GameBoard::is_legal(const Move move, const LegalMoveMasks& masks) const
 {
-    static constexpr std::array<Direction, 4> directions = {
-        Direction::upright, Direction::upleft, Direction::downleft, Direction::downright};
-    assert(bishops().test_all(from) && "not a bishop");
-    return pieces_.sliding_moves(directions, from);
+    const auto from = to_bitboard(move.from());
+    if (!pieces_.of<Color>().test_any(from)) {
+        return false;
+    }
+    // only the moving piece's moves are generated, and the move has to match one of them flags and all
+    MoveList moves;
+    switch (*pieces_.type_at(from)) {
+    case PieceType::pawn:
+        add_legal_moves<Color, PieceType::pawn, MoveScope::all>(moves, masks, from);
+        break;
+    case PieceType::knight:
+        add_legal_moves<Color, PieceType::knight, MoveScope::all>(moves, masks, from);
+        break;
+    case PieceType::bishop:
+        add_legal_moves<Color, PieceType::bishop, MoveScope::all>(moves, masks, from);
+        break;
+    case PieceType::rook:
+        add_legal_moves<Color, PieceType::rook, MoveScope::all>(moves, masks, from);
+        break;
+    case PieceType::queen:
+        add_legal_moves<Color, PieceType::queen, MoveScope::all>(moves, masks, from);
+        break;
+    case PieceType::king:
+        add_legal_moves<Color, PieceType::king, MoveScope::all>(moves, masks, from);
+        break;
+    }
+    return std::ranges::find(moves, move) != moves.end();
 }
 
-BitBoard GameBoard::rook_moves(const BitBoard from) const
+bool GameBoard::is_legal(const Move move) const
 {
-    static constexpr std::array<Direction, 4> directions = {
-        Direction::right, Direction::up, Direction::left, Direction::down};
-    assert(rooks().test_all(from) && "not a rook");
-    return pieces_.sliding_moves(directions, from);
+    return is_legal(move, legal_move_masks());
 }
 
-BitBoard GameBoard::queen_moves(const BitBoard from) const
+bool GameBoard::is_legal(const Move move, const LegalMoveMasks& masks) const
 {
-    static constexpr std::array<Direction, 8> directions = {
-        Direction::right,
-        Direction::upright,
-        Direction::up,
-        Direction::upleft,
-        Direction::left,
-        Direction::downleft,
-        Direction::down,
-        Direction::downright};
-    assert(queens().test_any(from) && "not a queen");
-    return pieces_.sliding_moves(directions, from);
+    return (active_color() == PieceColor::black) ? is_legal<PieceColor::black>(move, masks)
+                                                 : is_legal<PieceColor::white>(move, masks);
 }
 
-bool GameBoard::white_can_castle_kingside() const
+PieceColor GameBoard::active_color() const
 {
-    static constexpr BitBoard between_squares{0x00'00'00'00'00'00'00'06};
-    static constexpr BitBoard king_squares{0x00'00'00'00'00'00'00'0E};
-    return !white_kingside_castle_piece_moved_ && can_castle<PieceColor::white>(between_squares, king_squares);
+    return active_color_;
 }
 
-bool GameBoard::white_can_castle_queenside() const
+PieceColor GameBoard::inactive_color() const
 {
-    static constexpr BitBoard between_squares{0x00'00'00'00'00'00'00'70};
-    static constexpr BitBoard king_squares{0x00'00'00'00'00'00'00'38};
-    return !white_queenside_castle_piece_moved_ && can_castle<PieceColor::white>(between_squares, king_squares);
+    return opposite_color(active_color_);
 }
 
-bool GameBoard::black_can_castle_kingside() const
+bool GameBoard::is_active_piece(const Position& position) const
 {
-    static constexpr BitBoard between_squares{0x06'00'00'00'00'00'00'00};
-    static constexpr BitBoard king_squares{0x0E'00'00'00'00'00'00'00};
-    return !black_kingside_castle_piece_moved_ && can_castle<PieceColor::black>(between_squares, king_squares);
+    return active_color_board().test(position);
 }
 
-bool GameBoard::black_can_castle_queenside() const
+BitBoard GameBoard::knight_moves(const BitBoard from) const
 {
-    static constexpr BitBoard between_squares{0x70'00'00'00'00'00'00'00};
-    static constexpr BitBoard king_squares{0x38'00'00'00'00'00'00'00};
-    return !black_queenside_castle_piece_moved_ && can_castle<PieceColor::black>(between_squares, king_squares);
+    assert(knights().test_all(from) && "not a knight");
+    return knight_attacks(to_square(from));
 }
 
-BitBoard GameBoard::king_standard_moves(const BitBoard from) const
+BitBoard GameBoard::bishop_moves(const BitBoard from) const
 {
-    assert(kings().test_all(from) && "not a king");
-    return BitBoard::neighbors_cardinal_and_diagonal(from);
+    assert(bishops().test_all(from) && "not a bishop");
+    return bishop_attacks(to_square(from), occupied());
 }
 
-bool GameBoard::has_valid_move() const
+BitBoard GameBoard::rook_moves(const BitBoard from) const
 {
-    return std::ranges::any_of(active_color_board().to_bitboard_vector(), [this](const auto from) {
-        return !valid_moves_bitboard(from).empty();
-    });
+    assert(rooks().test_all(from) && "not a rook");
+    return rook_attacks(to_square(from), occupied());
+}
+
+BitBoard GameBoard::queen_moves(const BitBoard from) const
+{
+    assert(queens().test_any(from) && "not a queen");
+    return queen_attacks(to_square(from), occupied());
 }
 
-void GameBoard::set_state(const BoardState& state)
+BitBoard GameBoard::king_standard_moves(const BitBoard from) const
 {
-    en_passant_square_ = state.en_passant_square;
-    pieces_ = state.pieces;
-    active_color_ = state.active_color;
-    black_queenside_castle_piece_moved_ = state.black_queenside_castle_piece_moved;
-    black_kingside_castle_piece_moved_ = state.black_kingside_castle_piece_moved;
-    white_queenside_castle_piece_moved_ = state.white_queenside_castle_piece_moved;
-    white_kingside_castle_piece_moved_ = state.white_kingside_castle_piece_moved;
+    assert(kings().test_all(from) && "not a king");
+    return king_attacks(to_square(from));
+}
+
+template <PieceColor Color>
+GameBoard::PositionStatus GameBoard::compute_status() const
+{
+    PositionStatus status;
+    const auto masks = legal_move_masks<Color>();
+    status.in_check = !masks.checkers.empty();
+    add_to_status<Color, PieceType::pawn>(status, masks);
+    add_to_status<Color, PieceType::knight>(status, masks);
+    add_to_status<Color, PieceType::bishop>(status, masks);
+    add_to_status<Color, PieceType::rook>(status, masks);
+    add_to_status<Color, PieceType::queen>(status, masks);
+    add_to_status<Color, PieceType::king>(status, masks);
+    return status;
+}
+
+template <PieceColor Color, PieceType Type>
+void GameBoard::add_to_status(PositionStatus& status, const LegalMoveMasks& masks) const
+{
+    static constexpr int promotion_choices = 4;
+
+    for (const auto square : squares(pieces_.of<Piece{Color, Type}>())) {
+        const auto destinations = legal_destinations<Color, Type>(to_bitboard(square), masks);
+        status.legal_destinations[square] = destinations;
+        status.legal_move_count += static_cast<int>(destinations.count());
+        if constexpr (Type == PieceType::pawn) {
+            const auto promotions = (destinations & piece_row<opposite_color_v<Color>>()).count();
+            status.legal_move_count += static_cast<int>(promotions * (promotion_choices - 1));
+        }
+    }
 }
 
 } // namespace chess
@@ -1,13 +1,21 @@
 #pragma once
 
+#include "attacks.h"
 #include "bit_board.h"
 #include "board.h"
+#include "move.h"
+#include "move_list.h"
 #include "pieces.h"
 #include "vec2.h"
+#include "zobrist.h"
 
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <optional>
-#include <set>
+#include <string_view>
 #include <utility>
+#include <vector>
 
 namespace chess {
 
@@ -15,25 +23,111 @@ class GameBoard
 {
   public:
     using Position = BoardPieces::Position;
-    using Move = BoardPieces::Move;
+    using PositionMove = BoardPieces::Move;
+
+    // What the last make_move took off the board and put on it, so that evaluators can follow a game move by move
+    // without rescanning the board. The moving piece comes first in both lists.
+    struct PieceChanges
+    {
+        struct Change
+        {
+            Piece piece;
+            Square square;
+        };
+        // a move removes and adds at most two pieces
+        static constexpr int max_changes = 2;
+
+        std::array<Change, max_changes> removed;
+        std::array<Change, max_changes> added;
+        int removed_count{0};
+        int added_count{0};
+    };
+
+    // What the legal moves of the position add up to. Worked out on first use after the position changes and kept
+    // until it changes again, so asking every frame costs nothing.
+    struct PositionStatus
+    {
+        bool in_check{false};
+        // promotions count once for each piece that can be chosen
+        int legal_move_count{0};
+        // where the piece on each square can legally move, indexed by Square; empty for the side not to move
+        std::array<BitBoard, square_count> legal_destinations{};
+
+        [[nodiscard]] bool is_checkmate() const noexcept
+        {
+            return in_check && legal_move_count == 0;
+        }
+        [[nodiscard]] bool is_stalemate() const noexcept
+        {
+            return !in_check && legal_move_count == 0;
+        }
+    };
+
+    // Everything a non-king move needs to stay legal, computed once per position instead of playing out each
+    // candidate move and testing for self-check. Only good for the position it was computed for, so a caller that
+    // generates a node's moves in several steps can compute it once and pass it to each.
+    struct LegalMoveMasks
+    {
+        BitBoard checkers;
+        // squares a non-king move must land on: everything when not in check, the checker and the squares
+        // between it and the king in single check, nothing in double check
+        BitBoard check_evasions;
+        // our pieces pinned to the king, which may only move along the line through both
+        BitBoard pinned;
+        Square king_square;
+        // squares attacked by the opponent with the king taken off the board
+        BitBoard king_danger;
+    };
+
+    [[nodiscard]] static GameBoard from_fen(std::string_view fen);
 
     [[nodiscard]] std::optional<Piece> piece_at(Position position) const;
-    void make_move(Move move, std::optional<PieceType> promotion_selection = std::nullopt);
-    [[nodiscard]] bool is_promotion_move(Move move) const;
-    [[nodiscard]] std::vector<Position> valid_moves_vector(Position from);
-    [[nodiscard]] std::set<Position> valid_moves_set(Position from);
+    [[nodiscard]] const BoardPieces& pieces() const;
+    [[nodiscard]] Move
+    encode_move(PositionMove move, std::optional<PieceType> promotion_selection = std::nullopt) const;
+    void make_move(PositionMove move, std::optional<PieceType> promotion_selection = std::nullopt);
+    void make_move(Move move);
+    void unmake_move();
+    [[nodiscard]] PieceChanges last_move_changes() const;
+    [[nodiscard]] bool is_promotion_move(PositionMove move) const;
+    [[nodiscard]] BitBoard valid_moves_bitboard(BitBoard from) const;
+    void generate_legal_moves(MoveList& moves) const;
+    // for the side to move
+    [[nodiscard]] LegalMoveMasks legal_move_masks() const;
+    // the legal captures, including en passant, and promotions, without producing any other move
+    void generate_legal_captures(MoveList& moves) const;
+    void generate_legal_captures(MoveList& moves, const LegalMoveMasks& masks) const;
+    // the legal moves that generate_legal_captures leaves out
+    void generate_legal_quiets(MoveList& moves) const;
+    void generate_legal_quiets(MoveList& moves, const LegalMoveMasks& masks) const;
+    // whether a move from somewhere else, such as the transposition table, is one of the legal moves here
+    [[nodiscard]] bool is_legal(Move move) const;
+    [[nodiscard]] bool is_legal(Move move, const LegalMoveMasks& masks) const;
     [[nodiscard]] PieceColor active_color() const;
     [[nodiscard]] PieceColor inactive_color() const;
     [[nodiscard]] bool is_active_piece(const Position& position) const;
+    // every square the side's pieces attack, with all pieces standing where they are
     template <PieceColor Color>
-    [[nodiscard]] std::vector<Position> attacked_by_vector() const;
+    [[nodiscard]] BitBoard attacked_by() const;
+    // Pieces of both colours among the occupancy that attack the square, found by looking outward from the square
+    // with each piece's attack pattern. Removing pieces from the occupancy reveals the sliders behind them.
+    [[nodiscard]] BitBoard attackers_to(Square square, BitBoard occupancy) const;
     template <PieceColor Color>
     [[nodiscard]] bool is_in_check() const;
     [[nodiscard]] bool is_active_in_check() const;
     [[nodiscard]] bool is_in_checkmate() const;
     [[nodiscard]] bool is_in_stalemate() const;
+    // not safe to call on a board that other threads are reading, since the first call fills in the cache
+    [[nodiscard]] const PositionStatus& status() const;
     [[nodiscard]] bool is_game_over() const;
+    [[nodiscard]] bool is_repetition() const;
+    [[nodiscard]] bool is_draw_by_repetition() const;
+    [[nodiscard]] bool is_draw_by_fifty_move_rule() const;
+    [[nodiscard]] ZobristKey zobrist_key() const;
+    [[nodiscard]] int halfmove_clock() const;
     [[nodiscard]] Position active_king_position() const;
+    [[nodiscard]] BitBoard active_color_board() const;
+    [[nodiscard]] BitBoard inactive_color_board() const;
 
   private:
     using BitBoardMove = BoardPieces::BitBoardMove;
@@ -44,26 +138,24 @@ class GameBoard
         kingside
     };
 
-    struct BoardState
+    using CastlingRights = std::uint8_t;
+    inline static constexpr CastlingRights white_kingside_castling{0b0001};
+    inline static constexpr CastlingRights white_queenside_castling{0b0010};
+    inline static constexpr CastlingRights black_kingside_castling{0b0100};
+    inline static constexpr CastlingRights black_queenside_castling{0b1000};
+    inline static constexpr CastlingRights all_castling{0b1111};
+
+    // Only what make_move throws away; everything else is recovered by reversing the move on the bitboards.
+    struct UndoRecord
     {
-        BoardState(const GameBoard& board)
-            : pieces{board.pieces_},
-              en_passant_square{board.en_passant_square_},
-              active_color{board.active_color_},
-              black_queenside_castle_piece_moved{board.black_queenside_castle_piece_moved_},
-              black_kingside_castle_piece_moved{board.black_kingside_castle_piece_moved_},
-              white_queenside_castle_piece_moved{board.white_queenside_castle_piece_moved_},
-              white_kingside_castle_piece_moved{board.white_kingside_castle_piece_moved_}
-        {}
-
-        BoardPieces pieces;
-        BitBoard en_passant_square;
-        PieceColor active_color{PieceColor::white};
-        bool black_queenside_castle_piece_moved{false};
-        bool black_kingside_castle_piece_moved{false};
-        bool white_queenside_castle_piece_moved{false};
-        bool white_kingside_castle_piece_moved{false};
+        ZobristKey zobrist_key;
+        std::optional<PieceType> captured;
+        Move move;
+        std::uint16_t halfmove_clock;
+        std::uint8_t en_passant_square;
+        CastlingRights castling_rights;
     };
+    inline static constexpr std::uint8_t no_en_passant_square{square_count};
 
     inline static constexpr BitBoard black_king_position{BitBoard::Position{0, 4}};
     inline static constexpr BitBoard black_kingside_rook_position{BitBoard::Position{0, 7}};
@@ -81,14 +173,16 @@ class GameBoard
     inline static constexpr BitBoard white_castle_kingside_rook_move{BitBoard::Position{7, 5}};
     inline static constexpr BitBoard white_castle_queenside_rook_move{BitBoard::Position{7, 3}};
 
-    std::vector<BoardState> history_;
+    std::vector<UndoRecord> history_;
     BoardPieces pieces_{BoardPieces::make_standard_setup_board()};
     BitBoard en_passant_square_;
     PieceColor active_color_{PieceColor::white};
-    bool black_queenside_castle_piece_moved_{false};
-    bool black_kingside_castle_piece_moved_{false};
-    bool white_queenside_castle_piece_moved_{false};
-    bool white_kingside_castle_piece_moved_{false};
+    CastlingRights castling_rights_{all_castling};
+    // plies since the last capture or pawn move
+    std::uint16_t halfmove_clock_{0};
+    ZobristKey zobrist_key_{compute_zobrist_key()};
+    // reset by every change of position
+    mutable std::optional<PositionStatus> status_;
 
     [[nodiscard]] BitBoard pawns() const
     {
@@ -130,165 +224,293 @@ class GameBoard
     }
 
     template <PieceColor Color>
-    [[nodiscard]] BitBoard attacked_by() const;
-    [[nodiscard]] BitBoard attacked_by_color(PieceColor color) const;
+    [[nodiscard]] BitBoard attacked_by(BitBoard occupancy) const;
     [[nodiscard]] bool is_color_in_check(PieceColor color) const;
-    void make_move(BitBoardMove move, std::optional<PieceType> promotion_selection = std::nullopt);
-    void make_move(Piece piece, BitBoardMove move, std::optional<PieceType> promotion_selection = std::nullopt);
-    void castle(Piece piece, BitBoardMove king_move);
-    void undo_previous_move();
-    void white_castle(BitBoardMove king_move);
-    void black_castle(BitBoardMove king_move);
-    void update_en_passant_state(Piece piece, BitBoardMove move);
+    [[nodiscard]] static std::optional<BitBoardMove> castling_rook_move(BitBoardMove king_move);
+    template <PieceColor Color, CastlingSide Side>
+    [[nodiscard]] static constexpr CastlingRights castling_right() noexcept;
+    template <PieceColor Color, CastlingSide Side>
+    [[nodiscard]] static constexpr BitBoardMove castling_king_move() noexcept;
+    template <PieceColor Color, CastlingSide Side>
+    [[nodiscard]] static constexpr BitBoardMove castling_rook_move() noexcept;
+    // the rook's part of a castling move by the given side
+    template <PieceColor Color>
+    [[nodiscard]] static constexpr BitBoardMove castling_rook_move(Move move) noexcept;
     void update_castling_state(BitBoardMove move);
+    // The public make_move and unmake_move pick the side once and run these, which know it at compile time.
+    template <PieceColor Color>
+    void make_move(Move move);
+    template <PieceColor Color>
+    void unmake_move(const UndoRecord& record);
+    [[nodiscard]] ZobristKey compute_zobrist_key() const;
+    [[nodiscard]] int repetition_count(int stop_at) const;
 
     template <PieceColor Color>
-    [[nodiscard]] BitBoard valid_moves_bitboard(BitBoard from) const;
-    [[nodiscard]] BitBoard valid_moves_bitboard(BitBoard from) const;
+    [[nodiscard]] LegalMoveMasks legal_move_masks() const;
+    // which moves a generator produces
+    enum class MoveScope
+    {
+        all,
+        captures_and_promotions,
+        quiets,
+    };
+
+    template <PieceColor Color, PieceType Type, MoveScope Scope = MoveScope::all>
+    [[nodiscard]] BitBoard legal_destinations(BitBoard from, const LegalMoveMasks& masks) const;
+    // the moves of some of the side's pieces of one type, one piece at a time
+    template <PieceColor Color, PieceType Type, MoveScope Scope>
+    void add_legal_moves(MoveList& moves, const LegalMoveMasks& masks, BitBoard pieces) const;
+    // the moves of all of the side's pawns at once, with whole-board shifts
+    template <PieceColor Color, MoveScope Scope>
+    void add_pawn_moves(MoveList& moves, const LegalMoveMasks& masks) const;
+    template <PieceColor Color>
+    [[nodiscard]] bool is_legal_en_passant(BitBoard from) const;
+    template <PieceColor Color, MoveScope Scope>
+    void generate_legal_moves(MoveList& moves, const LegalMoveMasks& masks) const;
+    template <PieceColor Color>
+    [[nodiscard]] bool is_legal(Move move, const LegalMoveMasks& masks) const;
     [[nodiscard]] bool is_valid_move(BitBoardMove move) const;
-    [[nodiscard]] bool has_valid_move() const;
     template <PieceColor Color>
+    [[nodiscard]] PositionStatus compute_status() const;
+    template <PieceColor Color, PieceType Type>
+    void add_to_status(PositionStatus& status, const LegalMoveMasks& masks) const;
     [[nodiscard]] bool is_promotion_move(BitBoardMove move) const;
     template <PieceColor Color>
-    [[nodiscard]] bool is_castling_move(BitBoardMove move) const;
-    [[nodiscard]] bool test_move_for_self_check(const BitBoardMove& move) const;
+    [[nodiscard]] bool is_promotion_move(BitBoardMove move) const;
+    // every square attacked by any of the pawns at once, for sets of pawns the per-square tables would loop over
     template <PieceColor Color>
-    [[nodiscard]] BitBoard attacking_bitboard(BitBoard from) const;
+    [[nodiscard]] static BitBoard pawn_attacks_of(BitBoard pawns);
     template <PieceColor Color>
     [[nodiscard]] BitBoard pawn_attacking_squares(BitBoard from) const;
     template <PieceColor Color>
-    [[nodiscard]] BitBoard pawn_attacking_moves(BitBoard from) const;
-    template <PieceColor Color>
-    [[nodiscard]] BitBoard pawn_moves(BitBoard from) const;
+    [[nodiscard]] BitBoard pawn_push_moves(BitBoard from) const;
     [[nodiscard]] BitBoard knight_moves(BitBoard from) const;
     [[nodiscard]] BitBoard bishop_moves(BitBoard from) const;
     [[nodiscard]] BitBoard rook_moves(BitBoard from) const;
     [[nodiscard]] BitBoard queen_moves(BitBoard from) const;
     [[nodiscard]] BitBoard king_standard_moves(BitBoard from) const;
+    // the squares the opponent attacks decide which castling moves are legal
     template <PieceColor Color>
-    [[nodiscard]] BitBoard king_castling_moves() const;
-    template <PieceColor Color>
-    [[nodiscard]] BitBoard king_moves(BitBoard from) const;
-    template <PieceColor Color>
-    [[nodiscard]] bool can_castle(BitBoard between_squares, BitBoard king_squares) const;
-    [[nodiscard]] bool white_can_castle_kingside() const;
-    [[nodiscard]] bool white_can_castle_queenside() const;
-    [[nodiscard]] bool black_can_castle_kingside() const;
-    [[nodiscard]] bool black_can_castle_queenside() const;
+    [[nodiscard]] BitBoard king_castling_moves(BitBoard attacked) const;
+    template <PieceColor Color, CastlingSide Side>
+    [[nodiscard]] bool can_castle(BitBoard attacked) const;
 
     template <PieceColor Color>
     [[nodiscard]] bool is_pawn_start_square(const BitBoard position) const
     {
         return pawn_row<Color>().test_any(position);
     }
-
-    [[nodiscard]] BitBoard active_color_board() const;
-    [[nodiscard]] BitBoard inactive_color_board() const;
-
-    void set_state(const BoardState& state);
 };
 
 template <PieceColor Color>
-BitBoard GameBoard::pawn_attacking_squares(const BitBoard from) const
+BitBoard GameBoard::pawn_attacks_of(const BitBoard pawns)
 {
-    assert(pawns().test_all(from) && "not a pawn");
     if constexpr (Color == PieceColor::black) {
-        return BitBoard::shift<downright>(from) | BitBoard::shift<downleft>(from);
+        return BitBoard::shift<downright>(pawns) | BitBoard::shift<downleft>(pawns);
     } else {
-        return BitBoard::shift<upright>(from) | BitBoard::shift<upleft>(from);
+        return BitBoard::shift<upright>(pawns) | BitBoard::shift<upleft>(pawns);
     }
 }
 
 template <PieceColor Color>
-BitBoard GameBoard::pawn_attacking_moves(BitBoard from) const
+BitBoard GameBoard::pawn_attacking_squares(const BitBoard from) const
 {
     assert(pawns().test_all(from) && "not a pawn");
-    BitBoard attacking_moves = pawn_attacking_squares<Color>(from);
-    if constexpr (Color == PieceColor::black) {
-        return attacking_moves &= (white() | en_passant_square_);
-    } else {
-        return attacking_moves &= (black() | en_passant_square_);
-    }
+    return pawn_attacks(Color, to_square(from));
 }
 
 template <PieceColor Color>
-BitBoard GameBoard::pawn_moves(const BitBoard from) const
+BitBoard GameBoard::pawn_push_moves(const BitBoard from) const
 {
     assert(pawns().test_all(from) && "not a pawn");
     const auto n_spaces = is_pawn_start_square<Color>(from) ? 2 : 1;
-    BitBoard forward_moves;
     if constexpr (Color == PieceColor::white) {
-        forward_moves = pieces_.sliding_moves<up>(from, n_spaces).clear(occupied());
-    } else if constexpr (Color == PieceColor::black) {
-        forward_moves = pieces_.sliding_moves<down>(from, n_spaces).clear(occupied());
+        return pieces_.sliding_moves<up>(from, n_spaces).clear(occupied());
+    } else {
+        return pieces_.sliding_moves<down>(from, n_spaces).clear(occupied());
     }
-    return forward_moves | pawn_attacking_moves<Color>(from);
 }
 
-template <PieceColor Color>
-BitBoard GameBoard::king_castling_moves() const
+template <PieceColor Color, GameBoard::CastlingSide Side>
+constexpr GameBoard::CastlingRights GameBoard::castling_right() noexcept
 {
     if constexpr (Color == PieceColor::black) {
-        return (black_can_castle_kingside() ? black_castle_kingside_king_move : BitBoard{}) |
-               (black_can_castle_queenside() ? black_castle_queenside_king_move : BitBoard{});
+        return (Side == CastlingSide::kingside) ? black_kingside_castling : black_queenside_castling;
     } else {
-        return (white_can_castle_kingside() ? white_castle_kingside_king_move : BitBoard{}) |
-               (white_can_castle_queenside() ? white_castle_queenside_king_move : BitBoard{});
+        return (Side == CastlingSide::kingside) ? white_kingside_castling : white_queenside_castling;
+    }
+}
+
+template <PieceColor Color, GameBoard::CastlingSide Side>
+constexpr GameBoard::BitBoardMove GameBoard::castling_king_move() noexcept
+{
+    if constexpr (Color == PieceColor::black) {
+        return {black_king_position,
+                (Side == CastlingSide::kingside) ? black_castle_kingside_king_move : black_castle_queenside_king_move};
+    } else {
+        return {white_king_position,
+                (Side == CastlingSide::kingside) ? white_castle_kingside_king_move : white_castle_queenside_king_move};
+    }
+}
+
+template <PieceColor Color, GameBoard::CastlingSide Side>
+constexpr GameBoard::BitBoardMove GameBoard::castling_rook_move() noexcept
+{
+    if constexpr (Color == PieceColor::black) {
+        return (Side == CastlingSide::kingside)
+                   ? BitBoardMove{black_kingside_rook_position, black_castle_kingside_rook_move}
+                   : BitBoardMove{black_queenside_rook_position, black_castle_queenside_rook_move};
+    } else {
+        return (Side == CastlingSide::kingside)
+                   ? BitBoardMove{white_kingside_rook_position, white_castle_kingside_rook_move}
+                   : BitBoardMove{white_queenside_rook_position, white_castle_queenside_rook_move};
     }
 }
 
 template <PieceColor Color>
-bool GameBoard::can_castle(const BitBoard between_squares, const BitBoard king_squares) const
+constexpr GameBoard::BitBoardMove GameBoard::castling_rook_move(const Move move) noexcept
 {
-    return (!between_squares.test_any(occupied()) && !king_squares.test_any(attacked_by<opposite_color_v<Color>>()));
+    assert(move.is_castling());
+    return (move.flags() == Move::kingside_castle) ? castling_rook_move<Color, CastlingSide::kingside>()
+                                                   : castling_rook_move<Color, CastlingSide::queenside>();
 }
 
 template <PieceColor Color>
-BitBoard GameBoard::king_moves(const BitBoard from) const
+BitBoard GameBoard::king_castling_moves(const BitBoard attacked) const
 {
-    assert(kings().test_all(from) && "not a king");
-    return king_standard_moves(from) | king_castling_moves<Color>();
+    constexpr auto kingside = CastlingSide::kingside;
+    constexpr auto queenside = CastlingSide::queenside;
+    return (can_castle<Color, kingside>(attacked) ? castling_king_move<Color, kingside>().to : BitBoard{}) |
+           (can_castle<Color, queenside>(attacked) ? castling_king_move<Color, queenside>().to : BitBoard{});
+}
+
+template <PieceColor Color, GameBoard::CastlingSide Side>
+bool GameBoard::can_castle(const BitBoard attacked) const
+{
+    if ((castling_rights_ & castling_right<Color, Side>()) == 0) {
+        return false;
+    }
+    const auto king_move = castling_king_move<Color, Side>();
+    const auto rook_from = to_square(castling_rook_move<Color, Side>().from);
+    const auto king_from = to_square(king_move.from);
+    const auto king_path = king_move.from | squares_between(king_from, to_square(king_move.to)) | king_move.to;
+    return !squares_between(king_from, rook_from).test_any(occupied()) &&
+           !king_path.test_any(attacked);
 }
 
 template <PieceColor Color>
-BitBoard GameBoard::valid_moves_bitboard(const BitBoard from) const
+GameBoard::LegalMoveMasks GameBoard::legal_move_masks() const
 {
-    BitBoard moves;
-    const auto piece = pieces_.at(from);
-    if (active_color() != Color || !piece.has_value()) {
-        return moves;
+    constexpr auto Opponent = opposite_color_v<Color>;
+    const auto king = pieces_.of<Piece{Color, PieceType::king}>();
+    const auto king_square = to_square(king);
+    const auto own = pieces_.of<Color>();
+    const auto opponent = pieces_.of<Opponent>();
+    const auto orthogonal_sliders = (rooks() | queens()) & opponent;
+    const auto diagonal_sliders = (bishops() | queens()) & opponent;
+
+    LegalMoveMasks masks;
+    masks.king_square = king_square;
+    masks.king_danger = attacked_by<Opponent>(occupied() & ~king);
+    masks.checkers = attackers_to(king_square, occupied()) & opponent;
+
+    // sliders that would see the king through the opponent's pieces alone pin whatever single piece of ours is
+    // in the way
+    const auto pinners = (rook_attacks(king_square, opponent) & orthogonal_sliders) |
+                         (bishop_attacks(king_square, opponent) & diagonal_sliders);
+    for (const auto pinner : squares(pinners)) {
+        const auto blockers = squares_between(king_square, pinner) & own;
+        if (blockers.has_single_position()) {
+            masks.pinned.set(blockers);
+        }
     }
-    assert(piece->color == Color);
 
-    switch (piece->type) {
-    case PieceType::pawn:
-        moves = pawn_moves<Color>(from);
-        break;
-    case PieceType::knight:
-        moves = knight_moves(from);
+    switch (masks.checkers.count()) {
+    case 0:
+        masks.check_evasions = ~BitBoard{};
         break;
-    case PieceType::bishop:
-        moves = bishop_moves(from);
+    case 1:
+        // nothing lies between the king and a checking knight, pawn or king
+        masks.check_evasions = masks.checkers | squares_between(king_square, to_square(masks.checkers));
         break;
-    case PieceType::rook:
-        moves = rook_moves(from);
-        break;
-    case PieceType::queen:
-        moves = queen_moves(from);
-        break;
-    case PieceType::king:
-        moves = king_moves<Color>(from);
+    default:
         break;
     }
+    return masks;
+}
 
-    for (const auto to : moves.to_bitboard_vector()) {
-        if (test_move_for_self_check(BitBoardMove{from, to})) {
-            moves.clear(to);
+template <PieceColor Color>
+bool GameBoard::is_legal_en_passant(const BitBoard from) const
+{
+    constexpr auto Opponent = opposite_color_v<Color>;
+    const auto captured = (Color == PieceColor::white) ? BitBoard::shift<down>(en_passant_square_)
+                                                       : BitBoard::shift<up>(en_passant_square_);
+    const auto king_square = to_square(pieces_.of<Piece{Color, PieceType::king}>());
+    const auto after = (occupied() & ~from & ~captured) | en_passant_square_;
+    const auto opponent = pieces_.of<Opponent>();
+
+    // both pawns leave the capturing rank at once, which the pin masks cannot see, so check every attacker
+    // against the resulting occupancy
+    return (attackers_to(king_square, after) & opponent).empty();
+}
+
+template <PieceColor Color, PieceType Type, GameBoard::MoveScope Scope>
+BitBoard GameBoard::legal_destinations(const BitBoard from, const LegalMoveMasks& masks) const
+{
+    assert(pieces_.at_checked(from) == (Piece{Color, Type}));
+    const auto opponent = pieces_.of<opposite_color_v<Color>>();
+    if constexpr (Type == PieceType::king) {
+        if constexpr (Scope == MoveScope::captures_and_promotions) {
+            return king_standard_moves(from) & opponent & ~masks.king_danger;
+        } else if constexpr (Scope == MoveScope::quiets) {
+            return (king_standard_moves(from) & ~occupied() & ~masks.king_danger) |
+                   king_castling_moves<Color>(masks.king_danger);
+        } else {
+            // the king's own square is on its castling path, so whenever taking the king off the board uncovers
+            // more of the path the king was in check and can't castle anyway
+            return (king_standard_moves(from) & ~pieces_.of<Color>() & ~masks.king_danger) |
+                   king_castling_moves<Color>(masks.king_danger);
+        }
+    } else {
+        // no piece leaves the line it shares with the king and pinner: knights can't move at all, and bishops
+        // pinned along a rank or file, rooks pinned along a diagonal and pawns pinned along a rank have no moves on it
+        const auto pin_line =
+            masks.pinned.test_any(from) ? line_through(masks.king_square, to_square(from)) : ~BitBoard{};
+
+        if constexpr (Type == PieceType::pawn) {
+            // only a pawn one step from promoting has pushes that count as promotions
+            const bool is_promoting = pawn_row<opposite_color_v<Color>>().test_any(from);
+            if constexpr (Scope == MoveScope::quiets) {
+                const auto pushes = is_promoting ? BitBoard{} : pawn_push_moves<Color>(from);
+                return pushes & pin_line & masks.check_evasions;
+            } else {
+                const auto pushes =
+                    (Scope == MoveScope::all || is_promoting) ? pawn_push_moves<Color>(from) : BitBoard{};
+                const auto captures = pawn_attacking_squares<Color>(from) & opponent;
+                auto moves = (pushes | captures) & pin_line & masks.check_evasions;
+                if (pawn_attacking_squares<Color>(from).test_any(en_passant_square_) &&
+                    is_legal_en_passant<Color>(from)) {
+                    moves.set(en_passant_square_);
+                }
+                return moves;
+            }
+        } else {
+            BitBoard moves;
+            if constexpr (Type == PieceType::knight) {
+                moves = knight_moves(from);
+            } else if constexpr (Type == PieceType::bishop) {
+                moves = bishop_moves(from);
+            } else if constexpr (Type == PieceType::rook) {
+                moves = rook_moves(from);
+            } else {
+                moves = queen_moves(from);
+            }
+            const auto targets = (Scope == MoveScope::all)                       ? ~pieces_.of<Color>()
+                                 : (Scope == MoveScope::captures_and_promotions) ? opponent
+                                                                                 : ~occupied();
+            return moves & targets & pin_line & masks.check_evasions;
         }
     }
-    moves.clear(pieces_.of<Color>());
-
-    return moves;
 }
 
 template <PieceColor Color>
@@ -301,64 +523,29 @@ template <PieceColor Color>
     return piece_row<opposite_color_v<Color>>().test_all(move.to);
 }
 
-// TODO: remove attacks that would self-check or rename
 template <PieceColor Color>
-BitBoard GameBoard::attacking_bitboard(const BitBoard from) const
+BitBoard GameBoard::attacked_by(const BitBoard occupancy) const
 {
-    BitBoard moves;
-    const auto piece = pieces_.at(from);
-    if (!piece.has_value()) {
-        return moves;
-    }
-    assert(piece->color == Color);
-
-    switch (piece->type) {
-    case PieceType::pawn:
-        moves = pawn_attacking_squares<Color>(from);
-        break;
-    case PieceType::knight:
-        moves = knight_moves(from);
-        break;
-    case PieceType::bishop:
-        moves = bishop_moves(from);
-        break;
-    case PieceType::rook:
-        moves = rook_moves(from);
-        break;
-    case PieceType::queen:
-        moves = queen_moves(from);
-        break;
-    case PieceType::king:
-        moves = king_standard_moves(from);
-        break;
+    const auto own = pieces_.of<Color>();
+    auto attacked = pawn_attacks_of<Color>(pawns() & own) | knight_attacks_of(knights() & own) |
+                    slider_attacks_of((rooks() | queens()) & own, (bishops() | queens()) & own, occupancy);
+    for (const auto king : squares(kings() & own)) {
+        attacked.set(king_attacks(king));
     }
-
-    moves.clear(pieces_.of<Color>());
-
-    return moves;
+    return attacked;
 }
 
 template <PieceColor Color>
 BitBoard GameBoard::attacked_by() const
 {
-    BitBoard attacked_by;
-    for (const auto position : pieces_.of<Color>().to_bitboard_vector()) {
-        attacked_by.set(attacking_bitboard<Color>(position));
-    }
-    return attacked_by;
-}
-
-template <PieceColor Color>
-std::vector<GameBoard::Position> GameBoard::attacked_by_vector() const
-{
-    return attacked_by<Color>().to_position_vector();
+    return attacked_by<Color>(occupied());
 }
 
 template <PieceColor Color>
 bool GameBoard::is_in_check() const
 {
-    const auto king = pieces_.of<Piece{Color, PieceType::king}>();
-    return king.test_any(attacked_by<opposite_color_v<Color>>());
+    const auto king_square = to_square(pieces_.of<Piece{Color, PieceType::king}>());
+    return attackers_to(king_square, occupied()).test_any(pieces_.of<opposite_color_v<Color>>());
 }
 
 inline BitBoard GameBoard::active_color_board() const
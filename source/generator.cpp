@@ -0,0 +1,54 @@
+#include "generator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+namespace chess {
+
+CoroutineFramePool::~CoroutineFramePool()
+{
+    for (const auto& size_class : size_classes_) {
+        auto* frame = size_class.free;
+        while (frame != nullptr) {
+            auto* const next = frame->next;
+            ::operator delete(frame);
+            frame = next;
+        }
+    }
+}
+
+CoroutineFramePool& CoroutineFramePool::for_this_thread() noexcept
+{
+    thread_local CoroutineFramePool pool;
+    return pool;
+}
+
+CoroutineFramePool::SizeClass& CoroutineFramePool::size_class(const std::size_t size)
+{
+    const auto found = std::ranges::find(size_classes_, size, &SizeClass::size);
+    if (found != size_classes_.end()) {
+        return *found;
+    }
+    return size_classes_.emplace_back(SizeClass{.size = size, .free = nullptr});
+}
+
+void* CoroutineFramePool::allocate(const std::size_t size)
+{
+    auto& free = size_class(size).free;
+    if (free == nullptr) {
+        return ::operator new(std::max(size, sizeof(FreeFrame)));
+    }
+    auto* const frame = free;
+    free = frame->next;
+    return frame;
+}
+
+void CoroutineFramePool::deallocate(void* const frame, const std::size_t size) noexcept
+{
+    // allocate already made the class, so finding it can't allocate
+    const auto found = std::ranges::find(size_classes_, size, &SizeClass::size);
+    found->free = ::new (frame) FreeFrame{found->free};
+}
+
+} // namespace chess
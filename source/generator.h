@@ -0,0 +1,129 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace chess {
+
+// Recycles coroutine frames on the thread that created them. A finished coroutine's frame goes onto a free list for
+// its size, so a search allocates frames only until it first reaches its deepest node and reuses them from then on.
+class CoroutineFramePool
+{
+  public:
+    CoroutineFramePool() = default;
+    CoroutineFramePool(const CoroutineFramePool&) = delete;
+    CoroutineFramePool& operator=(const CoroutineFramePool&) = delete;
+    ~CoroutineFramePool();
+
+    [[nodiscard]] static CoroutineFramePool& for_this_thread() noexcept;
+
+    [[nodiscard]] void* allocate(std::size_t size);
+    // the frame must come from this pool's allocate with the same size
+    void deallocate(void* frame, std::size_t size) noexcept;
+
+  private:
+    struct FreeFrame
+    {
+        FreeFrame* next;
+    };
+    struct SizeClass
+    {
+        std::size_t size;
+        FreeFrame* free;
+    };
+
+    [[nodiscard]] SizeClass& size_class(std::size_t size);
+
+    // a coroutine function always asks for the same size, so there is one class per function and a search has few
+    std::vector<SizeClass> size_classes_;
+};
+
+// A coroutine that produces values one at a time and runs only when the next one is asked for. Its frame comes from
+// the creating thread's CoroutineFramePool, so a generator must be finished with on the thread that created it.
+template <typename T>
+class Generator
+{
+  public:
+    struct promise_type
+    {
+        T value{};
+
+        [[nodiscard]] Generator get_return_object() noexcept
+        {
+            return Generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        [[nodiscard]] std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+        [[nodiscard]] std::suspend_always final_suspend() const noexcept
+        {
+            return {};
+        }
+        std::suspend_always yield_value(T yielded) noexcept
+        {
+            value = std::move(yielded);
+            return {};
+        }
+        void return_void() const noexcept {}
+        void unhandled_exception() const
+        {
+            throw;
+        }
+
+        [[nodiscard]] static void* operator new(const std::size_t size)
+        {
+            return CoroutineFramePool::for_this_thread().allocate(size);
+        }
+        static void operator delete(void* frame, const std::size_t size) noexcept
+        {
+            CoroutineFramePool::for_this_thread().deallocate(frame, size);
+        }
+    };
+
+    Generator(Generator&& other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+    Generator& operator=(Generator&& other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    Generator(const Generator&) = delete;
+    Generator& operator=(const Generator&) = delete;
+    ~Generator()
+    {
+        destroy();
+    }
+
+    // runs the coroutine up to its next value, or nullopt once it has returned
+    [[nodiscard]] std::optional<T> next()
+    {
+        if (handle_.done()) {
+            return std::nullopt;
+        }
+        handle_.resume();
+        if (handle_.done()) {
+            return std::nullopt;
+        }
+        return handle_.promise().value;
+    }
+
+  private:
+    explicit Generator(const std::coroutine_handle<promise_type> handle) noexcept : handle_{handle} {}
+
+    void destroy() noexcept
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+} // namespace chess
@@ -0,0 +1,96 @@
+#include "hash_table.h"
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+namespace chess {
+
+namespace {
+
+constexpr std::size_t bytes_per_mb = std::size_t{1} << 20;
+
+std::atomic<std::size_t> next_stats_stripe{0};
+
+} // namespace
+
+LocklessHashTable::LocklessHashTable(const std::size_t size_mb)
+{
+    if (size_mb == 0) {
+        throw std::invalid_argument("hash table size must be at least 1 MB");
+    }
+    // largest power of two that fits, so that the index is a mask of the key
+    entry_count_ = std::bit_floor(size_mb * bytes_per_mb / sizeof(Entry));
+    entries_ = std::make_unique<Entry[]>(entry_count_);
+}
+
+std::optional<LocklessHashTable::Value> LocklessHashTable::probe(const Key key) const noexcept
+{
+    const auto& slot = entry(key);
+    const auto value = slot.value.load(std::memory_order_relaxed);
+    const auto check = slot.check.load(std::memory_order_relaxed);
+    auto& stats = stats_[stats_stripe_index()];
+    if (value == 0) {
+        stats.misses.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    if ((check ^ value) != key) {
+        stats.collisions.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+    }
+    stats.hits.fetch_add(1, std::memory_order_relaxed);
+    return value;
+}
+
+void LocklessHashTable::store(const Key key, const Value value) noexcept
+{
+    assert(value != 0 && "zero marks an empty slot");
+    auto& slot = entry(key);
+    slot.check.store(key ^ value, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    stats_[stats_stripe_index()].stores.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LocklessHashTable::clear() noexcept
+{
+    for (std::size_t i = 0; i < entry_count_; ++i) {
+        entries_[i].check.store(0, std::memory_order_relaxed);
+        entries_[i].value.store(0, std::memory_order_relaxed);
+    }
+    reset_stats();
+}
+
+HashTableStats LocklessHashTable::stats() const noexcept
+{
+    HashTableStats total;
+    for (const auto& stripe : stats_) {
+        total.hits += stripe.hits.load(std::memory_order_relaxed);
+        total.misses += stripe.misses.load(std::memory_order_relaxed);
+        total.collisions += stripe.collisions.load(std::memory_order_relaxed);
+        total.stores += stripe.stores.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void LocklessHashTable::reset_stats() noexcept
+{
+    for (auto& stripe : stats_) {
+        stripe.hits.store(0, std::memory_order_relaxed);
+        stripe.misses.store(0, std::memory_order_relaxed);
+        stripe.collisions.store(0, std::memory_order_relaxed);
+        stripe.stores.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::size_t LocklessHashTable::stats_stripe_index() noexcept
+{
+    thread_local const std::size_t index =
+        next_stats_stripe.fetch_add(1, std::memory_order_relaxed) % stats_stripe_count;
+    return index;
+}
+
+} // namespace chess
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+namespace chess {
+
+struct HashTableStats
+{
+    std::uint64_t hits{0};
+    // the slot was empty
+    std::uint64_t misses{0};
+    // the slot held another key, or an entry torn by a concurrent store
+    std::uint64_t collisions{0};
+    std::uint64_t stores{0};
+
+    [[nodiscard]] std::uint64_t probes() const noexcept
+    {
+        return hits + misses + collisions;
+    }
+};
+
+// Fixed-size, always-replace table of 64-bit values keyed by 64-bit hashes that any number of threads can probe and
+// store into without locks. Each slot holds the value and the key XOR the value as two independent atomics; a probe
+// only returns a value when the pair XORs back to the probed key, so a slot half-written by another thread reads as a
+// collision instead of as a wrong value. A value of zero marks an empty slot and cannot be stored.
+class LocklessHashTable
+{
+  public:
+    using Key = std::uint64_t;
+    using Value = std::uint64_t;
+
+    explicit LocklessHashTable(std::size_t size_mb);
+
+    [[nodiscard]] std::size_t entry_count() const noexcept
+    {
+        return entry_count_;
+    }
+
+    [[nodiscard]] std::optional<Value> probe(Key key) const noexcept;
+    void store(Key key, Value value) noexcept;
+    // not safe to call while other threads are using the table
+    void clear() noexcept;
+
+    [[nodiscard]] HashTableStats stats() const noexcept;
+    void reset_stats() noexcept;
+
+  private:
+    struct Entry
+    {
+        std::atomic<Key> check{0};
+        std::atomic<Value> value{0};
+    };
+
+    std::unique_ptr<Entry[]> entries_;
+    std::size_t entry_count_;
+
+    // statistics are spread over cache-line sized stripes, one per thread (modulo the stripe count), so that
+    // counting doesn't make every probing thread contend on the same line
+    struct alignas(64) StatsStripe
+    {
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::uint64_t> collisions{0};
+        std::atomic<std::uint64_t> stores{0};
+    };
+    static constexpr std::size_t stats_stripe_count = 64;
+    mutable std::array<StatsStripe, stats_stripe_count> stats_;
+
+    [[nodiscard]] static std::size_t stats_stripe_index() noexcept;
+
+    [[nodiscard]] const Entry& entry(const Key key) const noexcept
+    {
+        return entries_[key & (entry_count_ - 1)];
+    }
+    [[nodiscard]] Entry& entry(const Key key) noexcept
+    {
+        return entries_[key & (entry_count_ - 1)];
+    }
+};
+
+} // namespace chess
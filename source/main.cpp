@@ -1,11 +1,14 @@
+#include "engine_player.h"
 #include "event_handlers.h"
 #include "game.h"
 #include "grid_view.h"
+#include "nnue.h"
 #include "pieces.h"
 #include "sdl_point.h"
 #include "sdl_rectangle.h"
 #include "sprite_map_grid.h"
 #include "timing.h"
+#include "zobrist.h"
 
 #include "sdl_fmt.h"
 #include "vec2_fmt.h"
@@ -27,10 +30,11 @@
 
 #include <chrono>
 #include <exception>
+#include <filesystem>
+#include <future>
 #include <iostream>
 #include <map>
 #include <memory>
-#include <set>
 #include <string>
 #include <thread>
 
@@ -120,6 +124,22 @@ class ChessApplication
                 piece_textures_.insert({piece, make_piece_texture(piece, {100, 100})});
             }
         }
+
+        load_nnue_network();
+    }
+
+    // the engine falls back to its hand-written evaluation without a network file
+    void load_nnue_network()
+    {
+        if (!std::filesystem::exists(nnue_network_filename)) {
+            return;
+        }
+        try {
+            engine_.set_nnue_network(std::make_shared<const NnueNetwork>(nnue_network_filename));
+            spdlog::info("engine evaluating with {}", nnue_network_filename);
+        } catch (const std::exception& error) {
+            spdlog::warn("not using {}: {}", nnue_network_filename, error.what());
+        }
     }
 
     sdl::Texture make_piece_texture(const Piece piece, const sdl::Point<int> size)
@@ -165,6 +185,60 @@ class ChessApplication
             promotion_selection_ = std::nullopt;
             show_game_over_popup_ = pieces_.is_game_over();
         }
+        update_engine();
+    }
+
+    [[nodiscard]] bool is_engine_turn() const
+    {
+        return engine_color_.has_value() && *engine_color_ == pieces_.active_color();
+    }
+
+    void update_engine()
+    {
+        if (engine_move_.valid()) {
+            if (engine_move_.wait_for(chrono::seconds{0}) != std::future_status::ready) {
+                return;
+            }
+            const auto move = engine_move_.get();
+            const auto lock = std::lock_guard{pieces_mutex_};
+            // the search worked on a copy, so the board may have moved on without it
+            if (pieces_.zobrist_key() != engine_move_key_ || !pieces_.is_legal(move)) {
+                spdlog::warn("engine: discarding a move for a position that is no longer on the board");
+                return;
+            }
+            pieces_.make_move(move);
+            const auto& report = engine_.last_report();
+            spdlog::info(
+                "engine: depth {}, score {}, {} nodes, {:.0f} nodes/sec",
+                report.depth,
+                report.score,
+                report.nodes,
+                report.nodes_per_second()
+            );
+            show_game_over_popup_ = pieces_.is_game_over();
+        } else if (is_engine_turn() && !pieces_.is_game_over()) {
+            engine_move_key_ = pieces_.zobrist_key();
+            engine_.reset_stop();
+            engine_move_ = std::async(std::launch::async, [this, board = pieces_] {
+                return engine_.select_move(board);
+            });
+        }
+    }
+
+    // stops a search in progress and throws its result away
+    void cancel_engine_move()
+    {
+        if (engine_move_.valid()) {
+            engine_.stop();
+            engine_move_.wait();
+            engine_move_ = {};
+        }
+    }
+
+    void new_game()
+    {
+        cancel_engine_move();
+        pieces_ = GameBoard{};
     }
 
     void initialize_event_handlers()
@@ -249,7 +323,7 @@ class ChessApplication
             if (ImGui::Button("New Game")) {
                 ImGui::CloseCurrentPopup();
                 show_game_over_popup_ = false;
-                pieces_ = GameBoard{};
+                new_game();
             }
             ImGui::EndPopup();
         }
@@ -283,7 +357,13 @@ class ChessApplication
         if (ImGui::BeginMainMenuBar()) {
             if (ImGui::BeginMenu("Menu")) {
                 if (ImGui::MenuItem("New Game")) {
-                    pieces_ = GameBoard{};
+                    new_game();
+                }
+                if (ImGui::MenuItem("Engine Plays White", nullptr, engine_color_ == PieceColor::white)) {
+                    toggle_engine_color(PieceColor::white);
+                }
+                if (ImGui::MenuItem("Engine Plays Black", nullptr, engine_color_ == PieceColor::black)) {
+                    toggle_engine_color(PieceColor::black);
                 }
                 ImGui::EndMenu();
             }
@@ -291,6 +371,12 @@ class ChessApplication
         }
     }
 
+    void toggle_engine_color(const PieceColor color)
+    {
+        cancel_engine_move();
+        engine_color_ = (engine_color_ == color) ? std::nullopt : std::optional{color};
+    }
+
     void show_game_window()
     {
         ImGui::SetNextWindowSizeConstraints(ImVec2(400, 400), ImVec2(FLT_MAX, FLT_MAX));
@@ -354,22 +440,25 @@ class ChessApplication
             renderer_.fill_rectangle(
                 board_display_.grid_cell_local(transform_chess_to_grid_view(*selected_piece_coordinate_))
             );
-            for (const auto move : selected_piece_valid_moves_) {
+            for (const auto square : squares(selected_piece_valid_moves_)) {
+                const auto move = to_bitboard(square).to_position();
                 renderer_.fill_rectangle(board_display_.grid_cell_local(transform_chess_to_grid_view(move)));
             }
         }
 
-        if (pieces_.is_in_checkmate()) {
+        // cached by the board until the next move, so this does no move generation on idle frames
+        const auto& status = pieces_.status();
+        if (status.is_checkmate()) {
             renderer_.set_draw_color(pallete::color_with_alpha(pallete::black, 0x7F));
             renderer_.fill_rectangle(
                 board_display_.grid_cell_local(transform_chess_to_grid_view(pieces_.active_king_position()))
             );
-        } else if (pieces_.is_active_in_check()) {
+        } else if (status.in_check) {
             renderer_.set_draw_color(pallete::color_with_alpha(pallete::light_red, 0x7F));
             renderer_.fill_rectangle(
                 board_display_.grid_cell_local(transform_chess_to_grid_view(pieces_.active_king_position()))
             );
-        } else if (pieces_.is_in_stalemate()) {
+        } else if (status.is_stalemate()) {
             renderer_.set_draw_color(pallete::color_with_alpha(pallete::light_purple, 0x7F));
             renderer_.fill_rectangle(
                 board_display_.grid_cell_local(transform_chess_to_grid_view(pieces_.active_king_position()))
@@ -377,13 +466,15 @@ class ChessApplication
         }
 
         if (highlight_attacked_) {
-            for (const auto attacked_position : pieces_.attacked_by_vector<PieceColor::black>()) {
+            for (const auto square : squares(pieces_.attacked_by<PieceColor::black>())) {
+                const auto attacked_position = to_bitboard(square).to_position();
                 renderer_.set_draw_color(pallete::color_with_alpha(pallete::light_purple, 0x7F));
                 renderer_.fill_rectangle(board_display_.grid_cell_local(transform_chess_to_grid_view(attacked_position))
                 );
             }
 
-            for (const auto attacked_position : pieces_.attacked_by_vector<PieceColor::white>()) {
+            for (const auto square : squares(pieces_.attacked_by<PieceColor::white>())) {
+                const auto attacked_position = to_bitboard(square).to_position();
                 renderer_.set_draw_color(pallete::color_with_alpha(pallete::light_red, 0x7F));
                 renderer_.fill_rectangle(board_display_.grid_cell_local(transform_chess_to_grid_view(attacked_position))
                 );
@@ -414,21 +505,24 @@ class ChessApplication
     void on_grid_cell_clicked(const sdl::Point<int>& point)
     {
         const auto lock = std::lock_guard{pieces_mutex_};
+        if (is_engine_turn()) {
+            return;
+        }
         const auto coord = transform_grid_view_to_chess(point);
         if (selected_piece_coordinate_.has_value()) {
-            if (!selected_piece_valid_moves_.contains(coord)) {
+            if (!selected_piece_valid_moves_.test(BitBoard{coord})) {
                 spdlog::debug("invalid move");
             } else {
-                const auto move = GameBoard::Move{*selected_piece_coordinate_, coord};
+                const auto move = GameBoard::PositionMove{*selected_piece_coordinate_, coord};
                 move_selection_ = move;
                 selecting_promotion_ = pieces_.is_promotion_move(move);
             }
             selected_piece_coordinate_ = std::nullopt;
-            selected_piece_valid_moves_.clear();
+            selected_piece_valid_moves_ = BitBoard{};
         } else {
             if (pieces_.is_active_piece(coord)) {
                 selected_piece_coordinate_ = std::optional{coord};
-                selected_piece_valid_moves_ = pieces_.valid_moves_set(coord);
+                selected_piece_valid_moves_ = pieces_.valid_moves_bitboard(BitBoard{coord});
             }
         }
     }
@@ -502,6 +596,7 @@ class ChessApplication
     ClickableGrid board_display_;
 
     static constexpr const char* sprite_map_filename = "resources/pieces_sprite_map.svg";
+    static constexpr const char* nnue_network_filename = "resources/network.nnue";
     SpriteGrid<Piece> pieces_sprite_map_;
     std::map<Piece, sdl::Texture> piece_textures_;
     std::array<PieceType, 4> promotion_piece_types_{
@@ -510,13 +605,19 @@ class ChessApplication
     std::mutex pieces_mutex_;
     GameBoard pieces_;
     std::optional<dm::Vec2<int>> selected_piece_coordinate_;
-    std::set<dm::Vec2<int>> selected_piece_valid_moves_;
-    std::atomic<std::optional<GameBoard::Move>> move_selection_;
+    BitBoard selected_piece_valid_moves_;
+    std::atomic<std::optional<GameBoard::PositionMove>> move_selection_;
     std::optional<PieceType> promotion_selection_;
     std::atomic_bool selecting_promotion_{false};
     std::atomic_bool highlight_attacked_{false};
     bool show_game_over_popup_{false};
 
+    EnginePlayer engine_;
+    std::optional<PieceColor> engine_color_;
+    std::future<Move> engine_move_;
+    // the position engine_move_ was asked for
+    ZobristKey engine_move_key_{0};
+
     EventHandlers<SDL_QuitEvent> quit_event_handlers_;
     EventHandlers<SDL_MouseButtonEvent> mouse_button_down_event_handlers_;
     EventHandlers<SDL_MouseButtonEvent> mouse_button_up_event_handlers_;
@@ -0,0 +1,157 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace chess {
+
+#if defined(_WIN32)
+
+namespace {
+
+[[noreturn]] void throw_last_error(const std::string& what)
+{
+    throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), what);
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    const auto what = "mapping " + path.string();
+    const auto file = CreateFileW(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        throw_last_error(what);
+    }
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) == 0) {
+        CloseHandle(file);
+        throw_last_error(what);
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    if (size_ == 0) {
+        CloseHandle(file);
+        return;
+    }
+    mapping_ = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping_ == nullptr) {
+        throw_last_error(what);
+    }
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        CloseHandle(mapping_);
+        throw_last_error(what);
+    }
+}
+
+void MappedFile::unmap() noexcept
+{
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    data_ = nullptr;
+    mapping_ = nullptr;
+    size_ = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)},
+      mapping_{std::exchange(other.mapping_, nullptr)}
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+    }
+    return *this;
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+    const auto what = "mapping " + path.string();
+    const auto file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file == -1) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+    struct stat status
+    {};
+    if (fstat(file, &status) == -1) {
+        const auto error = errno;
+        close(file);
+        throw std::system_error(error, std::generic_category(), what);
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ == 0) {
+        close(file);
+        return;
+    }
+    auto* const data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    const auto error = errno;
+    // the mapping keeps the file alive on its own
+    close(file);
+    if (data == MAP_FAILED) {
+        size_ = 0;
+        throw std::system_error(error, std::generic_category(), what);
+    }
+    data_ = static_cast<const std::byte*>(data);
+}
+
+void MappedFile::unmap() noexcept
+{
+    if (data_ != nullptr) {
+        munmap(const_cast<std::byte*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)}
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other) {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+} // namespace chess
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace chess {
+
+// A whole file mapped read-only into memory, so that large data such as network weights is paged in on demand and
+// shared between processes instead of being copied onto the heap. Unmapped on destruction.
+class MappedFile
+{
+  public:
+    // throws std::system_error when the file cannot be opened or mapped
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::byte> bytes() const noexcept
+    {
+        return {data_, size_};
+    }
+
+  private:
+    const std::byte* data_{nullptr};
+    std::size_t size_{0};
+#if defined(_WIN32)
+    void* mapping_{nullptr};
+#endif
+
+    void unmap() noexcept;
+};
+
+} // namespace chess
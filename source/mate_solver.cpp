@@ -0,0 +1,351 @@
+#include "mate_solver.h"
+
+#include "game.h"
+#include "move.h"
+#include "move_list.h"
+#include "pieces.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace chess {
+
+namespace {
+
+constexpr std::size_t bytes_per_mb = std::size_t{1} << 20;
+// nodes between looks at the clock
+constexpr std::uint64_t time_check_interval = 1024;
+
+// only a solved node has an infinite number, so sums stop just short of it
+std::uint32_t saturating_add(const std::uint32_t lhs, const std::uint32_t rhs) noexcept
+{
+    constexpr auto infinite = std::numeric_limits<std::uint32_t>::max();
+    if (lhs == infinite || rhs == infinite) {
+        return infinite;
+    }
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(std::uint64_t{lhs} + rhs, infinite - 1));
+}
+
+} // namespace
+
+MateSolver::MateSolver(const MateSolverLimits limits, const std::size_t table_size_mb) : limits_{limits}
+{
+    if (table_size_mb == 0) {
+        throw std::invalid_argument("mate solver table size must be at least 1 MB");
+    }
+    // largest power of two that fits, so that the index is a mask of the key
+    table_.resize(std::bit_floor(table_size_mb * bytes_per_mb / sizeof(Bucket)));
+}
+
+MateSolverResult MateSolver::solve(const GameBoard& board)
+{
+    // empty entries belong to generation 0, which only comes round again once every 65536 solves
+    if (++generation_ == 0) {
+        std::ranges::fill(table_, Bucket{});
+        generation_ = 1;
+    }
+    // a search never goes deeper than the position after max_ply plies
+    children_.resize(static_cast<std::size_t>(std::max(limits_.max_ply, 0)) + 1);
+    board_ = board;
+    attacker_ = board.active_color();
+    ply_ = 0;
+    nodes_ = 0;
+    next_time_check_ = time_check_interval;
+    start_time_ = Clock::now();
+    stopped_ = false;
+
+    // every pass but the last has to disprove the mate before the next one starts, so the cap roughly doubles to keep
+    // the number of passes down
+    max_ply_ = std::clamp(limits_.initial_max_ply, 0, std::max(limits_.max_ply, 0));
+    auto root = search(infinite, infinite);
+    while (is_disproved(root) && max_ply_ < limits_.max_ply) {
+        max_ply_ = std::min(2 * max_ply_ + 1, limits_.max_ply);
+        root = search(infinite, infinite);
+    }
+
+    MateSolverResult result;
+    if (root.phi == 0) {
+        result.outcome = MateSolverResult::Outcome::mate;
+        result.line = mating_line();
+    } else if (root.delta == 0) {
+        result.outcome = MateSolverResult::Outcome::no_mate;
+    }
+    result.nodes = nodes_;
+    result.elapsed = Clock::now() - start_time_;
+    return result;
+}
+
+bool MateSolver::should_stop()
+{
+    if (stopped_) {
+        return true;
+    }
+    if (nodes_ >= limits_.max_nodes) {
+        stopped_ = true;
+    } else if (nodes_ >= next_time_check_) {
+        next_time_check_ = nodes_ + time_check_interval;
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start_time_);
+        stopped_ = elapsed >= limits_.max_time;
+    }
+    return stopped_;
+}
+
+bool MateSolver::is_attacker_to_move() const
+{
+    return board_.active_color() == attacker_;
+}
+
+bool MateSolver::is_proved(const Numbers& numbers) const
+{
+    return (is_attacker_to_move() ? numbers.phi : numbers.delta) == 0;
+}
+
+MateSolver::Numbers MateSolver::escaped() const
+{
+    return is_attacker_to_move() ? Numbers{.phi = infinite, .delta = 0} : Numbers{.phi = 0, .delta = infinite};
+}
+
+MateSolver::Numbers MateSolver::without_moves() const
+{
+    // the attacker has failed whether it is mated, stalemated or out of checks, while the defender only loses to mate
+    if (!is_attacker_to_move() && board_.is_active_in_check()) {
+        return Numbers{.phi = infinite, .delta = 0, .distance = 0};
+    }
+    return escaped();
+}
+
+bool MateSolver::is_disproved(const Numbers& numbers) const
+{
+    return (is_attacker_to_move() ? numbers.delta : numbers.phi) == 0;
+}
+
+const MateSolver::TableEntry* MateSolver::probe(const ZobristKey key) const noexcept
+{
+    const auto& bucket = table_[key & (table_.size() - 1)];
+    const auto found = std::ranges::find(bucket, key, &TableEntry::key);
+    return (found != bucket.end() && found->generation == generation_) ? &*found : nullptr;
+}
+
+void MateSolver::store(const ZobristKey key, const Numbers& numbers, const std::uint32_t work) noexcept
+{
+    auto& bucket = table_[key & (table_.size() - 1)];
+    auto slot = std::ranges::find(bucket, key, &TableEntry::key);
+    if (slot == bucket.end()) {
+        // entries left over from earlier solves count as no work, so they go first
+        slot = std::ranges::min_element(bucket, {}, [this](const TableEntry& entry) {
+            return (entry.generation == generation_) ? entry.work : 0;
+        });
+    }
+    *slot = TableEntry{
+        .key = key,
+        .numbers = numbers,
+        .work = work,
+        .remaining_plies = static_cast<std::uint16_t>(max_ply_ - ply_),
+        .generation = generation_,
+    };
+}
+
+MateSolver::Numbers MateSolver::evaluate()
+{
+    // mate and stalemate take precedence over the draw rules, so a mate on the hundredth halfmove still counts
+    MoveList moves;
+    board_.generate_legal_moves(moves);
+    if (moves.empty()) {
+        return without_moves();
+    }
+    if (board_.is_repetition() || board_.is_draw_by_fifty_move_rule()) {
+        // both depend on the moves that led here, which the key doesn't cover
+        auto numbers = escaped();
+        numbers.path_dependent = true;
+        return numbers;
+    }
+    const auto remaining_plies = max_ply_ - ply_;
+    if (remaining_plies <= 0) {
+        return escaped();
+    }
+    if (const auto* entry = probe(board_.zobrist_key()); entry != nullptr && !entry->numbers.path_dependent) {
+        // a proof holds if its mate still fits and a disproof if it had at least as much room, while unsolved
+        // numbers are only estimates anyway
+        const auto& numbers = entry->numbers;
+        const bool is_solved = numbers.phi == 0 || numbers.delta == 0;
+        if (!is_solved || (is_proved(numbers) ? numbers.distance <= remaining_plies
+                                              : entry->remaining_plies >= remaining_plies)) {
+            return numbers;
+        }
+    }
+    // every move has to be refuted to prove the side to move fails, and the more moves, the harder that is
+    return Numbers{.phi = 1, .delta = static_cast<Number>(moves.size())};
+}
+
+void MateSolver::generate_moves(MoveList& moves)
+{
+    board_.generate_legal_moves(moves);
+    if (!limits_.checks_only || !is_attacker_to_move()) {
+        return;
+    }
+    MoveList checks;
+    for (const auto move : moves) {
+        board_.make_move(move);
+        const bool is_check = board_.is_active_in_check();
+        board_.unmake_move();
+        if (is_check) {
+            checks.push_back(move);
+        }
+    }
+    moves = checks;
+}
+
+void MateSolver::make_move(const Move move)
+{
+    board_.make_move(move);
+    ++ply_;
+}
+
+void MateSolver::unmake_move()
+{
+    board_.unmake_move();
+    --ply_;
+}
+
+MateSolver::Numbers MateSolver::search(const Number phi_threshold, const Number delta_threshold)
+{
+    const auto nodes_before = nodes_++;
+    const auto key = board_.zobrist_key();
+    MoveList moves;
+    generate_moves(moves);
+    if (moves.empty()) {
+        const auto numbers = without_moves();
+        store(key, numbers, 1);
+        return numbers;
+    }
+
+    auto& children = children_[static_cast<std::size_t>(ply_)];
+    children.clear();
+    for (const auto move : moves) {
+        make_move(move);
+        children.push_back(Child{.move = move, .numbers = evaluate()});
+        unmake_move();
+    }
+
+    const bool is_attacker = is_attacker_to_move();
+    while (true) {
+        // the side to move needs only one child that fails for its opponent, but every child has to succeed for the
+        // opponent before the side to move fails
+        Numbers numbers{.phi = infinite, .delta = 0};
+        std::size_t best = 0;
+        auto second_best_delta = infinite;
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            const auto& child = children[i].numbers;
+            if (child.delta < numbers.phi) {
+                second_best_delta = numbers.phi;
+                numbers.phi = child.delta;
+                best = i;
+            } else if (child.delta < second_best_delta) {
+                second_best_delta = child.delta;
+            }
+            numbers.delta = saturating_add(numbers.delta, child.phi);
+        }
+
+        if (numbers.phi >= phi_threshold || numbers.delta >= delta_threshold || should_stop()) {
+            if (is_proved(numbers)) {
+                // the attacker takes the quickest of its mating moves and the defender the slowest of its replies
+                auto distance = is_attacker ? std::numeric_limits<std::uint16_t>::max() : std::uint16_t{0};
+                for (const auto& child : children) {
+                    if (is_attacker && child.numbers.delta == 0) {
+                        distance = std::min(distance, child.numbers.distance);
+                    } else if (!is_attacker) {
+                        distance = std::max(distance, child.numbers.distance);
+                    }
+                }
+                numbers.distance = static_cast<std::uint16_t>(distance + 1);
+            } else if (is_disproved(numbers)) {
+                // the attacker's failure depends on the path if any of its moves' does, while the defender needs
+                // only one escape that holds whatever the path
+                numbers.path_dependent =
+                    is_attacker ? std::ranges::any_of(children, &Numbers::path_dependent, &Child::numbers)
+                                : std::ranges::none_of(children, [](const Child& child) {
+                                      return child.numbers.delta == 0 && !child.numbers.path_dependent;
+                                  });
+            }
+            const auto work = std::min<std::uint64_t>(nodes_ - nodes_before, std::numeric_limits<std::uint32_t>::max());
+            store(key, numbers, static_cast<std::uint32_t>(work));
+            return numbers;
+        }
+
+        // The best child is searched until it is no longer the best or the parent reaches a threshold. The child's
+        // delta threshold is a quarter above the second best instead of just past it, so that two close children
+        // don't make the search switch back and forth between them on every small change.
+        const auto& child = children[best];
+        const auto child_phi_threshold = static_cast<Number>(std::min<std::uint64_t>(
+            std::uint64_t{delta_threshold} - numbers.delta + child.numbers.phi, infinite
+        ));
+        const auto child_delta_threshold = std::min<Number>(
+            phi_threshold, saturating_add(saturating_add(second_best_delta, second_best_delta / 4), 1)
+        );
+        make_move(child.move);
+        const auto child_numbers = search(child_phi_threshold, child_delta_threshold);
+        unmake_move();
+        children[best].numbers = child_numbers;
+    }
+}
+
+std::vector<Move> MateSolver::mating_line()
+{
+    std::vector<Move> line;
+    MoveList moves;
+    while (true) {
+        generate_moves(moves);
+        const bool is_attacker = is_attacker_to_move();
+        // whether the move keeps the mate going, seen from the side that plays it
+        const auto is_mating = [is_attacker](const Numbers& child) {
+            return (is_attacker ? child.delta : child.phi) == 0;
+        };
+        std::vector<Child> children;
+        for (const auto move : moves) {
+            make_move(move);
+            children.push_back(Child{.move = move, .numbers = evaluate()});
+            unmake_move();
+        }
+        // The proof may have lost positions on the line from the table, so those are solved again. The attacker only
+        // needs one mating move, so its most promising moves are tried until one mates.
+        if (is_attacker) {
+            std::ranges::sort(children, {}, [](const Child& child) { return child.numbers.delta; });
+        }
+        for (auto& child : children) {
+            if (is_attacker && std::ranges::any_of(children, is_mating, &Child::numbers)) {
+                break;
+            }
+            if (child.numbers.phi != 0 && child.numbers.delta != 0 && !should_stop()) {
+                make_move(child.move);
+                child.numbers = search(infinite, infinite);
+                unmake_move();
+            }
+        }
+
+        // the attacker takes the quickest mate and the defender the slowest
+        std::optional<Child> next;
+        for (const auto& child : children) {
+            if (is_mating(child.numbers) &&
+                (!next || (is_attacker ? child.numbers.distance < next->numbers.distance
+                                       : child.numbers.distance > next->numbers.distance))) {
+                next = child;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        line.push_back(next->move);
+        make_move(next->move);
+    }
+    return line;
+}
+
+} // namespace chess
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "evaluation.h"
+#include "game.h"
+#include "move.h"
+#include "move_list.h"
+#include "pieces.h"
+#include "zobrist.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace chess {
+
+struct MateSolverLimits
+{
+    std::uint64_t max_nodes{std::numeric_limits<std::uint64_t>::max()};
+    std::chrono::milliseconds max_time{std::chrono::milliseconds::max()};
+    // lines longer than this many plies count as not mating, so 2n - 1 looks for mates in n moves
+    int max_ply{max_search_ply};
+    // the cap of the first pass, which roughly doubles up to max_ply while no mate is found; set it to max_ply to
+    // search for a mate of known length in a single pass
+    int initial_max_ply{1};
+    // only consider checks for the attacker, which solves most composed problems far faster but misses mates that
+    // need a quiet move
+    bool checks_only{false};
+};
+
+struct MateSolverResult
+{
+    using Duration = std::chrono::steady_clock::duration;
+
+    enum class Outcome
+    {
+        // the side to move mates by force, and line holds the mate
+        mate,
+        // the side to move has no forced mate within the limits' max_ply
+        no_mate,
+        // the node or time limit ran out first
+        unknown,
+    };
+
+    Outcome outcome{Outcome::unknown};
+    // the attacker's moves mate as quickly as the proof allows and the defender's resist as long as it allows, which
+    // is not necessarily the shortest mate
+    std::vector<Move> line;
+    std::uint64_t nodes{0};
+    Duration elapsed{};
+};
+
+// Depth-first proof-number search for a forced mate by the side to move. Every node keeps a proof number, an estimate
+// of how many positions still have to be shown mated to prove it, and a disproof number for showing the defender
+// escapes. The search always expands the most-proving node while both numbers stay under thresholds passed down from
+// the parent, which keeps it depth-first while reaching the same node a best-first search would. Numbers for
+// positions left behind live in a fixed-size table, where entries that took the least work to compute are replaced
+// first. Positions that repeat or lie beyond the ply cap count as escapes.
+//
+// Without a tight cap the search tends to chase long lines of lone checks, since those keep the proof numbers small,
+// so by default the cap starts at a mate in one and widens up to max_ply for as long as the search fails to find a
+// mate. Proofs and estimates carry over from one cap to the next in the table. Not thread-safe; use one solver per
+// thread.
+class MateSolver
+{
+  public:
+    static constexpr std::size_t default_table_size_mb = 16;
+
+    // throws std::invalid_argument if the table is smaller than 1 MB
+    explicit MateSolver(MateSolverLimits limits = {}, std::size_t table_size_mb = default_table_size_mb);
+
+    [[nodiscard]] const MateSolverLimits& limits() const noexcept
+    {
+        return limits_;
+    }
+    void set_limits(const MateSolverLimits& limits) noexcept
+    {
+        limits_ = limits;
+    }
+
+    // forgets the previous position's numbers first, without spending time on clearing the table
+    [[nodiscard]] MateSolverResult solve(const GameBoard& board);
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    using Number = std::uint32_t;
+
+    static constexpr Number infinite = std::numeric_limits<Number>::max();
+
+    // Proof and disproof numbers from the side to move's point of view: phi is the one for its own goal, the proof
+    // number when the attacker is to move and the disproof number when the defender is, and delta is the other one.
+    // A node is solved when either is zero.
+    struct Numbers
+    {
+        Number phi{1};
+        Number delta{1};
+        // plies to mate once the node is proved, as long as the proof allows
+        std::uint16_t distance{0};
+        // An escape that relied on a repetition, which the same position reached by another path may not have.
+        // Table entries with it set are searched again instead of being reused.
+        bool path_dependent{false};
+    };
+
+    struct TableEntry
+    {
+        ZobristKey key{0};
+        Numbers numbers;
+        // nodes searched below this one, for deciding what to replace
+        std::uint32_t work{0};
+        // plies left before the cap when the numbers were stored, since a position reached by a shorter path than
+        // before has more room to be mated in
+        std::uint16_t remaining_plies{0};
+        // the solve that stored the entry, so that starting another doesn't have to clear the table
+        std::uint16_t generation{0};
+    };
+    static constexpr std::size_t bucket_size = 4;
+    using Bucket = std::array<TableEntry, bucket_size>;
+
+    struct Child
+    {
+        Move move;
+        Numbers numbers;
+    };
+
+    MateSolverLimits limits_;
+    std::vector<Bucket> table_;
+    std::uint16_t generation_{0};
+    // the children of the node being searched at each ply, kept to avoid allocating
+    std::vector<std::vector<Child>> children_;
+
+    GameBoard board_;
+    PieceColor attacker_{PieceColor::white};
+    int ply_{0};
+    // the cap of the current pass, which widens up to the limits' max_ply
+    int max_ply_{0};
+    std::uint64_t nodes_{0};
+    std::uint64_t next_time_check_{0};
+    Clock::time_point start_time_;
+    bool stopped_{false};
+
+    [[nodiscard]] bool should_stop();
+    // the rest refer to the position on the board
+    [[nodiscard]] bool is_attacker_to_move() const;
+    [[nodiscard]] bool is_proved(const Numbers& numbers) const;
+    [[nodiscard]] Numbers escaped() const;
+    [[nodiscard]] Numbers without_moves() const;
+    // whether the numbers show the attacker can't mate
+    [[nodiscard]] bool is_disproved(const Numbers& numbers) const;
+
+    [[nodiscard]] const TableEntry* probe(ZobristKey key) const noexcept;
+    void store(ZobristKey key, const Numbers& numbers, std::uint32_t work) noexcept;
+
+    // from the table if the position is there, exact if the rules decide it and estimated from its move count otherwise
+    [[nodiscard]] Numbers evaluate();
+    // the legal moves worth considering
+    void generate_moves(MoveList& moves);
+    void make_move(Move move);
+    void unmake_move();
+    // searches until one of the numbers reaches its threshold, then stores and returns them
+    Numbers search(Number phi_threshold, Number delta_threshold);
+    [[nodiscard]] std::vector<Move> mating_line();
+};
+
+} // namespace chess
@@ -0,0 +1,23 @@
+#include "move.h"
+
+#include "attacks.h"
+#include "pieces.h"
+
+#include <string>
+
+namespace chess {
+
+std::string to_uci_string(const Move move)
+{
+    const auto square_name = [](const Square square) {
+        const auto position = to_bitboard(square).to_position();
+        return std::string{static_cast<char>('a' + position.y()), static_cast<char>('8' - position.x())};
+    };
+    auto uci = square_name(move.from()) + square_name(move.to());
+    if (move.is_promotion()) {
+        uci += piece_type_short_names.at(move.promotion_type());
+    }
+    return uci;
+}
+
+} // namespace chess
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "attacks.h"
+#include "pieces.h"
+
+#include <cassert>
+#include <cstdint>
+#include <string>
+
+namespace chess {
+
+// A move packed into 16 bits: the from square in bits 0-5, the to square in bits 6-11 and four flag bits on top
+// recording what make_move would otherwise have to work out from the position.
+class Move
+{
+  public:
+    using Flags = std::uint8_t;
+    static constexpr Flags quiet{0b0000};
+    static constexpr Flags double_pawn_push{0b0001};
+    static constexpr Flags kingside_castle{0b0010};
+    static constexpr Flags queenside_castle{0b0011};
+    static constexpr Flags capture{0b0100};
+    static constexpr Flags en_passant_capture{0b0101};
+    // promotions set this bit, keep the capture bit, and put the promoted piece (knight to queen) in the low bits
+    static constexpr Flags promotion{0b1000};
+
+    constexpr Move() = default;
+    constexpr Move(const Square from, const Square to, const Flags flags = quiet) noexcept
+        : data_{static_cast<std::uint16_t>(from | (to << to_shift) | (flags << flags_shift))}
+    {
+        assert(from >= 0 && from < square_count && to >= 0 && to < square_count && flags < 16);
+    }
+
+    [[nodiscard]] static constexpr Move
+    make_promotion(const Square from, const Square to, const PieceType type, const bool is_capture) noexcept
+    {
+        assert(type != PieceType::pawn && type != PieceType::king);
+        const auto piece_bits = static_cast<Flags>(static_cast<int>(type) - static_cast<int>(PieceType::knight));
+        return Move{from, to, static_cast<Flags>(promotion | (is_capture ? capture : quiet) | piece_bits)};
+    }
+
+    [[nodiscard]] constexpr Square from() const noexcept
+    {
+        return data_ & square_mask;
+    }
+    [[nodiscard]] constexpr Square to() const noexcept
+    {
+        return (data_ >> to_shift) & square_mask;
+    }
+    [[nodiscard]] constexpr Flags flags() const noexcept
+    {
+        return static_cast<Flags>(data_ >> flags_shift);
+    }
+
+    [[nodiscard]] constexpr bool is_capture() const noexcept
+    {
+        return (flags() & capture) != 0;
+    }
+    [[nodiscard]] constexpr bool is_promotion() const noexcept
+    {
+        return (flags() & promotion) != 0;
+    }
+    [[nodiscard]] constexpr PieceType promotion_type() const noexcept
+    {
+        assert(is_promotion());
+        return static_cast<PieceType>(static_cast<int>(PieceType::knight) + (flags() & 0b0011));
+    }
+    [[nodiscard]] constexpr bool is_castling() const noexcept
+    {
+        return flags() == kingside_castle || flags() == queenside_castle;
+    }
+    [[nodiscard]] constexpr bool is_en_passant() const noexcept
+    {
+        return flags() == en_passant_capture;
+    }
+    [[nodiscard]] constexpr bool is_double_pawn_push() const noexcept
+    {
+        return flags() == double_pawn_push;
+    }
+
+    [[nodiscard]] constexpr std::uint16_t raw() const noexcept
+    {
+        return data_;
+    }
+    [[nodiscard]] static constexpr Move from_raw(const std::uint16_t data) noexcept
+    {
+        auto move = Move{};
+        move.data_ = data;
+        return move;
+    }
+
+    friend constexpr bool operator==(Move lhs, Move rhs) = default;
+
+  private:
+    static constexpr int to_shift = 6;
+    static constexpr int flags_shift = 12;
+    static constexpr std::uint16_t square_mask = 0b111111;
+
+    std::uint16_t data_{0};
+};
+static_assert(sizeof(Move) == 2);
+
+// where an en passant capture takes its pawn from: the from square's rank and the to square's file
+[[nodiscard]] constexpr Square en_passant_capture_square(const Move move) noexcept
+{
+    return (move.from() & ~7) | (move.to() & 7);
+}
+
+// long algebraic notation as used by UCI, e.g. "e2e4" or "e7e8q"
+[[nodiscard]] std::string to_uci_string(Move move);
+
+} // namespace chess
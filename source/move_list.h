@@ -0,0 +1,74 @@
+#pragma once
+
+#include "move.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+
+namespace chess {
+
+// Fixed-capacity move buffer meant to live on the stack; no chess position has more than 218 legal moves.
+class MoveList
+{
+  public:
+    using value_type = Move;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
+    static constexpr std::size_t capacity = 256;
+
+    void push_back(const value_type move) noexcept
+    {
+        assert(size_ < capacity && "move list overflow");
+        moves_[size_++] = move;
+    }
+
+    void clear() noexcept
+    {
+        size_ = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return size_;
+    }
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    [[nodiscard]] value_type& operator[](const std::size_t index) noexcept
+    {
+        assert(index < size_);
+        return moves_[index];
+    }
+    [[nodiscard]] const value_type& operator[](const std::size_t index) const noexcept
+    {
+        assert(index < size_);
+        return moves_[index];
+    }
+
+    [[nodiscard]] iterator begin() noexcept
+    {
+        return moves_.data();
+    }
+    [[nodiscard]] iterator end() noexcept
+    {
+        return moves_.data() + size_;
+    }
+    [[nodiscard]] const_iterator begin() const noexcept
+    {
+        return moves_.data();
+    }
+    [[nodiscard]] const_iterator end() const noexcept
+    {
+        return moves_.data() + size_;
+    }
+
+  private:
+    std::array<value_type, capacity> moves_;
+    std::size_t size_{0};
+};
+
+} // namespace chess
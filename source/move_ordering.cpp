@@ -0,0 +1,175 @@
+#include "move_ordering.h"
+
+#include "attacks.h"
+#include "evaluation.h"
+#include "game.h"
+#include "generator.h"
+#include "move.h"
+#include "move_list.h"
+#include "pieces.h"
+#include "see.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+namespace chess {
+
+namespace {
+
+// moves the best scored of the moves from index on to index
+void select_best(MoveList& moves, std::array<Score, MoveList::capacity>& scores, const std::size_t index) noexcept
+{
+    auto best = index;
+    for (auto i = index + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    std::swap(moves[best], moves[index]);
+    std::swap(scores[best], scores[index]);
+}
+
+} // namespace
+
+Score mvv_lva(const GameBoard& board, const Move move)
+{
+    const auto& pieces = board.pieces();
+    Score score = 0;
+    if (move.is_capture()) {
+        const auto victim = move.is_en_passant() ? PieceType::pawn : *pieces.type_at(to_bitboard(move.to()));
+        const auto attacker = *pieces.type_at(to_bitboard(move.from()));
+        // scaled so that the victim always dominates
+        score += 10 * piece_value(victim) - piece_value(attacker);
+    }
+    if (move.is_promotion()) {
+        score += piece_value(move.promotion_type()) - piece_value(PieceType::pawn);
+    }
+    return score;
+}
+
+void MoveOrderingHeuristics::clear() noexcept
+{
+    killers_ = {};
+    history_ = {};
+}
+
+void MoveOrderingHeuristics::record_quiet_cutoff(
+    const PieceColor color, const Move move, const int depth, const int ply
+) noexcept
+{
+    auto& killers = killers_[static_cast<std::size_t>(ply)];
+    if (killers[0] != move) {
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+
+    auto& color_history = history_[static_cast<std::size_t>(color)];
+    auto& entry = color_history[move.from()][move.to()];
+    entry += depth * depth;
+    if (entry >= max_history) {
+        for (auto& from : color_history) {
+            for (auto& score : from) {
+                score /= 2;
+            }
+        }
+    }
+}
+
+MovePicker::MovePicker(
+    const GameBoard& board,
+    MoveList& moves,
+    const Move hash_move,
+    const MoveOrderingHeuristics& heuristics,
+    const int ply
+)
+    : moves_{moves}
+{
+    const auto& killers = heuristics.killers(ply);
+    const auto color = board.active_color();
+    for (std::size_t i = 0; i < moves_.size(); ++i) {
+        const auto move = moves_[i];
+        if (move == hash_move) {
+            scores_[i] = hash_move_score;
+        } else if (move.is_capture() || move.is_promotion()) {
+            scores_[i] = capture_score + mvv_lva(board, move);
+        } else if (move == killers[0]) {
+            scores_[i] = first_killer_score;
+        } else if (move == killers[1]) {
+            scores_[i] = second_killer_score;
+        } else {
+            scores_[i] = heuristics.history(color, move);
+        }
+    }
+}
+
+std::optional<Move> MovePicker::next() noexcept
+{
+    if (next_index_ == moves_.size()) {
+        return std::nullopt;
+    }
+    select_best(moves_, scores_, next_index_);
+    return moves_[next_index_++];
+}
+
+Generator<Move> staged_moves(
+    const GameBoard& board, const Move hash_move, const MoveOrderingHeuristics& heuristics, const int ply
+)
+{
+    // the opponent's attacks behind the masks are the costly part, and every stage needs them
+    const auto masks = board.legal_move_masks();
+    if (board.is_legal(hash_move, masks)) {
+        co_yield hash_move;
+    }
+
+    // one list and score array serve the captures and then the quiet moves, which keeps the frame small
+    MoveList moves;
+    std::array<Score, MoveList::capacity> scores;
+    MoveList losing_captures;
+    board.generate_legal_captures(moves, masks);
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        scores[i] = mvv_lva(board, moves[i]);
+    }
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        select_best(moves, scores, i);
+        const auto move = moves[i];
+        if (move == hash_move) {
+            continue;
+        }
+        // exchanges are only worked out for the captures that are reached
+        if (move.is_capture() && see(board, move) < 0) {
+            losing_captures.push_back(move);
+            continue;
+        }
+        co_yield move;
+    }
+
+    const auto killers = heuristics.killers(ply);
+    for (const auto killer : killers) {
+        // a killer that is a capture here was a quiet move where it cut off, so it won't match any legal move
+        if (killer != hash_move && board.is_legal(killer, masks)) {
+            co_yield killer;
+        }
+    }
+
+    board.generate_legal_quiets(moves, masks);
+    const auto color = board.active_color();
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        scores[i] = heuristics.history(color, moves[i]);
+    }
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        select_best(moves, scores, i);
+        const auto move = moves[i];
+        if (move != hash_move && std::ranges::find(killers, move) == killers.end()) {
+            co_yield move;
+        }
+    }
+
+    for (const auto move : losing_captures) {
+        co_yield move;
+    }
+}
+
+} // namespace chess
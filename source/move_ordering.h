@@ -0,0 +1,80 @@
+#pragma once
+
+#include "attacks.h"
+#include "evaluation.h"
+#include "game.h"
+#include "generator.h"
+#include "move.h"
+#include "move_list.h"
+#include "pieces.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+namespace chess {
+
+// Most valuable victim, least valuable attacker: a capture's value for ordering, highest for taking the biggest piece
+// with the smallest one. Promotions count the gain of the promoted piece as well.
+[[nodiscard]] Score mvv_lva(const GameBoard& board, Move move);
+
+// Quiet move heuristics learned during a search, kept per search thread.
+class MoveOrderingHeuristics
+{
+  public:
+    static constexpr std::size_t killers_per_ply = 2;
+    using Killers = std::array<Move, killers_per_ply>;
+
+    void clear() noexcept;
+
+    [[nodiscard]] const Killers& killers(int ply) const noexcept
+    {
+        return killers_[static_cast<std::size_t>(ply)];
+    }
+    [[nodiscard]] int history(const PieceColor color, const Move move) const noexcept
+    {
+        return history_[static_cast<std::size_t>(color)][move.from()][move.to()];
+    }
+
+    // a quiet move caused a beta cutoff at this node
+    void record_quiet_cutoff(PieceColor color, Move move, int depth, int ply) noexcept;
+
+  private:
+    // history scores are halved when one reaches this so they stay below the killer and capture scores
+    static constexpr int max_history = 1 << 14;
+
+    std::array<Killers, max_search_ply> killers_{};
+    std::array<std::array<std::array<int, square_count>, square_count>, 2> history_{};
+};
+
+// Hands out the moves of a node best first: the hash move, captures and promotions by MVV-LVA, killer moves, and then
+// quiet moves by history score. Each call selects the best remaining move, so a node that cuts off early never pays
+// for sorting the rest.
+class MovePicker
+{
+  public:
+    MovePicker(
+        const GameBoard& board, MoveList& moves, Move hash_move, const MoveOrderingHeuristics& heuristics, int ply
+    );
+
+    [[nodiscard]] std::optional<Move> next() noexcept;
+
+  private:
+    static constexpr Score hash_move_score = 1'000'000;
+    static constexpr Score capture_score = 500'000;
+    static constexpr Score first_killer_score = 400'000;
+    static constexpr Score second_killer_score = 300'000;
+
+    MoveList& moves_;
+    std::array<Score, MoveList::capacity> scores_;
+    std::size_t next_index_{0};
+};
+
+// The moves of a node in stages, each generated only once the ones before it are used up: the hash move, captures
+// and promotions by MVV-LVA that don't lose material, the killer moves, quiet moves by history score, and last the
+// captures that lose material. A node that cuts off on the hash move or a capture never generates its quiet moves.
+// The board must be back in this position whenever the next move is asked for.
+[[nodiscard]] Generator<Move>
+staged_moves(const GameBoard& board, Move hash_move, const MoveOrderingHeuristics& heuristics, int ply);
+
+} // namespace chess
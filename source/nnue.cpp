@@ -0,0 +1,259 @@
+#include "nnue.h"
+
+#include "attacks.h"
+#include "evaluation.h"
+#include "game.h"
+#include "mapped_file.h"
+#include "piece_square_tables.h"
+#include "pieces.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace chess {
+
+static_assert(std::endian::native == std::endian::little, "network files are read in place as little-endian");
+
+namespace {
+
+constexpr std::array<char, 8> file_magic{'C', 'H', 'S', 'N', 'N', 'U', 'E', '1'};
+
+// padded to 32 bytes so that the weight arrays after it keep the mapping's alignment for vector loads
+struct FileHeader
+{
+    std::array<char, 8> magic;
+    std::uint32_t input_size;
+    std::uint32_t hidden_size;
+    std::array<std::uint8_t, 16> reserved;
+};
+static_assert(sizeof(FileHeader) == 32);
+
+constexpr std::size_t feature_weights_count = std::size_t{nnue_input_size} * nnue_hidden_size;
+constexpr std::size_t output_weights_count = 2 * std::size_t{nnue_hidden_size};
+
+constexpr std::size_t feature_weights_offset = sizeof(FileHeader);
+constexpr std::size_t feature_biases_offset = feature_weights_offset + feature_weights_count * sizeof(std::int16_t);
+constexpr std::size_t output_weights_offset = feature_biases_offset + nnue_hidden_size * sizeof(std::int16_t);
+constexpr std::size_t output_bias_offset = output_weights_offset + output_weights_count * sizeof(std::int16_t);
+constexpr std::size_t file_size = output_bias_offset + sizeof(std::int32_t);
+
+// Network output that stays clear of the scores the search reserves for mates.
+constexpr Score max_nnue_score = mate_score - max_search_ply - 1;
+
+using Row = const std::int16_t*;
+
+#if defined(__AVX2__)
+
+constexpr int lanes = 16;
+static_assert(nnue_hidden_size % lanes == 0);
+
+// out = in - the removed rows + the added rows
+void update_accumulator(
+    const std::int16_t* in, std::int16_t* out, const Row* removed, const int removed_count, const Row* added,
+    const int added_count
+) noexcept
+{
+    for (int i = 0; i < nnue_hidden_size; i += lanes) {
+        auto sum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        for (int row = 0; row < removed_count; ++row) {
+            sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(removed[row] + i)));
+        }
+        for (int row = 0; row < added_count; ++row) {
+            sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(added[row] + i)));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum);
+    }
+}
+
+// sum of clipped_relu(values[i]) * weights[i]
+std::int32_t clipped_dot(const std::int16_t* values, const std::int16_t* weights) noexcept
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto max = _mm256_set1_epi16(nnue_activation_max);
+    auto sum = _mm256_setzero_si256();
+    for (int i = 0; i < nnue_hidden_size; i += lanes) {
+        auto activation = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        activation = _mm256_min_epi16(_mm256_max_epi16(activation, zero), max);
+        const auto weight = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        // activations are at most 255, so neighbouring products summed into 32 bits can't overflow
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(activation, weight));
+    }
+    auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0b01'00'11'10));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0b10'11'00'01));
+    return _mm_cvtsi128_si32(half);
+}
+
+#else
+
+void update_accumulator(
+    const std::int16_t* in, std::int16_t* out, const Row* removed, const int removed_count, const Row* added,
+    const int added_count
+) noexcept
+{
+    // summed in a local copy, which the compiler can vectorize without worrying that out overlaps a row
+    std::array<std::int16_t, nnue_hidden_size> sum;
+    std::copy_n(in, nnue_hidden_size, sum.begin());
+    for (int row = 0; row < removed_count; ++row) {
+        for (int i = 0; i < nnue_hidden_size; ++i) {
+            sum[i] = static_cast<std::int16_t>(sum[i] - removed[row][i]);
+        }
+    }
+    for (int row = 0; row < added_count; ++row) {
+        for (int i = 0; i < nnue_hidden_size; ++i) {
+            sum[i] = static_cast<std::int16_t>(sum[i] + added[row][i]);
+        }
+    }
+    std::copy(sum.begin(), sum.end(), out);
+}
+
+std::int32_t clipped_dot(const std::int16_t* values, const std::int16_t* weights) noexcept
+{
+    std::int32_t sum = 0;
+    for (int i = 0; i < nnue_hidden_size; ++i) {
+        const auto activation = std::clamp<std::int32_t>(values[i], 0, nnue_activation_max);
+        sum += activation * weights[i];
+    }
+    return sum;
+}
+
+#endif
+
+template <typename T>
+void check_array_size(const std::vector<T>& values, const std::size_t expected_size)
+{
+    if (values.size() != expected_size) {
+        throw std::invalid_argument(
+            "network array has " + std::to_string(values.size()) + " values, expected " + std::to_string(expected_size)
+        );
+    }
+}
+
+template <typename T>
+void write_array(std::ofstream& file, const std::vector<T>& values)
+{
+    file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+} // namespace
+
+void save_nnue_network(const std::filesystem::path& path, const NnueParameters& parameters)
+{
+    // checked before the file is opened, so that bad parameters don't leave a truncated file behind
+    check_array_size(parameters.feature_weights, feature_weights_count);
+    check_array_size(parameters.feature_biases, nnue_hidden_size);
+    check_array_size(parameters.output_weights, output_weights_count);
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file) {
+        throw std::runtime_error("could not open " + path.string() + " for writing");
+    }
+    const auto header = FileHeader{
+        .magic = file_magic,
+        .input_size = nnue_input_size,
+        .hidden_size = nnue_hidden_size,
+        .reserved = {},
+    };
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_array(file, parameters.feature_weights);
+    write_array(file, parameters.feature_biases);
+    write_array(file, parameters.output_weights);
+    file.write(reinterpret_cast<const char*>(&parameters.output_bias), sizeof(parameters.output_bias));
+    if (!file) {
+        throw std::runtime_error("could not write " + path.string());
+    }
+}
+
+NnueNetwork::NnueNetwork(const std::filesystem::path& path) : file_{path}
+{
+    const auto bytes = file_.bytes();
+    FileHeader header{};
+    if (bytes.size() >= sizeof(header)) {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+    }
+    if (bytes.size() != file_size || header.magic != file_magic || header.input_size != nnue_input_size ||
+        header.hidden_size != nnue_hidden_size) {
+        throw std::runtime_error(path.string() + " is not a " + std::to_string(nnue_input_size) + "x" +
+                                 std::to_string(nnue_hidden_size) + " network file");
+    }
+    // the mapping is page aligned and every array starts at an even offset
+    feature_weights_ = reinterpret_cast<const std::int16_t*>(bytes.data() + feature_weights_offset);
+    feature_biases_ = reinterpret_cast<const std::int16_t*>(bytes.data() + feature_biases_offset);
+    output_weights_ = reinterpret_cast<const std::int16_t*>(bytes.data() + output_weights_offset);
+    std::memcpy(&output_bias_, bytes.data() + output_bias_offset, sizeof(output_bias_));
+}
+
+NnueEvaluator::NnueEvaluator(const NnueNetwork& network) : network_{network}, stack_(max_search_ply + 1) {}
+
+void NnueEvaluator::reset(const GameBoard& board)
+{
+    top_ = 0;
+    const auto& pieces = board.pieces();
+    for (const auto perspective : {PieceColor::black, PieceColor::white}) {
+        auto& values = stack_[top_].values[static_cast<std::size_t>(perspective)];
+        std::copy_n(network_.feature_biases(), nnue_hidden_size, values.begin());
+        for (const auto square : squares(pieces.occupied())) {
+            const auto piece = pieces.at_checked(to_bitboard(square));
+            const Row row = network_.feature_weights(nnue_feature(perspective, piece, square));
+            update_accumulator(values.data(), values.data(), nullptr, 0, &row, 1);
+        }
+    }
+}
+
+void NnueEvaluator::push(const GameBoard& board)
+{
+    if (top_ + 1 == stack_.size()) {
+        stack_.resize(stack_.size() * 2);
+    }
+    const auto changes = board.last_move_changes();
+    const auto& parent = stack_[top_];
+    auto& child = stack_[++top_];
+    for (const auto perspective : {PieceColor::black, PieceColor::white}) {
+        std::array<Row, GameBoard::PieceChanges::max_changes> removed{};
+        std::array<Row, GameBoard::PieceChanges::max_changes> added{};
+        for (int i = 0; i < changes.removed_count; ++i) {
+            const auto [piece, square] = changes.removed[static_cast<std::size_t>(i)];
+            removed[static_cast<std::size_t>(i)] = network_.feature_weights(nnue_feature(perspective, piece, square));
+        }
+        for (int i = 0; i < changes.added_count; ++i) {
+            const auto [piece, square] = changes.added[static_cast<std::size_t>(i)];
+            added[static_cast<std::size_t>(i)] = network_.feature_weights(nnue_feature(perspective, piece, square));
+        }
+        const auto index = static_cast<std::size_t>(perspective);
+        update_accumulator(
+            parent.values[index].data(), child.values[index].data(), removed.data(), changes.removed_count,
+            added.data(), changes.added_count
+        );
+    }
+}
+
+void NnueEvaluator::pop() noexcept
+{
+    assert(top_ > 0 && "no move to pop");
+    --top_;
+}
+
+Score NnueEvaluator::evaluate(const PieceColor side_to_move) const noexcept
+{
+    const auto& accumulator = stack_[top_];
+    const auto us = static_cast<std::size_t>(side_to_move);
+    const auto output = std::int64_t{clipped_dot(accumulator.values[us].data(), network_.output_weights())} +
+                        clipped_dot(accumulator.values[1 - us].data(), network_.output_weights() + nnue_hidden_size) +
+                        network_.output_bias();
+    const auto score = output * nnue_output_scale / (nnue_activation_max * nnue_output_weight_scale);
+    return static_cast<Score>(std::clamp<std::int64_t>(score, -max_nnue_score, max_nnue_score));
+}
+
+} // namespace chess
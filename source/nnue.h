@@ -0,0 +1,117 @@
+#pragma once
+
+#include "attacks.h"
+#include "game.h"
+#include "mapped_file.h"
+#include "piece_square_tables.h"
+#include "pieces.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace chess {
+
+// An efficiently updatable neural network evaluation: 768 inputs, one per colour, piece type and square, feed a
+// hidden layer of 256 kept for each side from its own point of view. Both halves go through a clipped ReLU into a
+// single output, with the side to move's half first. Everything is int16 fixed point so that a move only adds and
+// subtracts a few weight rows, and inference is a short integer dot product.
+inline constexpr int nnue_input_size = 2 * 6 * square_count;
+inline constexpr int nnue_hidden_size = 256;
+// hidden values are clipped to [0, nnue_activation_max], which stands for 1.0
+inline constexpr int nnue_activation_max = 255;
+// output weights are fixed point with this standing for 1.0
+inline constexpr int nnue_output_weight_scale = 64;
+// centipawns per unit of network output
+inline constexpr int nnue_output_scale = 400;
+
+// Input feature of a piece standing on a square, as seen by one side: its own pieces come first and black sees the
+// board with the ranks flipped, so both sides share the same weights.
+[[nodiscard]] constexpr int nnue_feature(const PieceColor perspective, const Piece piece, const Square square) noexcept
+{
+    const auto relative_color = (piece.color == perspective) ? 0 : 1;
+    const auto oriented_square = (perspective == PieceColor::white) ? square : square ^ 56;
+    return (relative_color * 6 + static_cast<int>(piece.type)) * square_count + oriented_square;
+}
+
+// The weights as plain arrays, for writing network files from training tools and tests.
+struct NnueParameters
+{
+    // nnue_hidden_size weights for each input feature in turn
+    std::vector<std::int16_t> feature_weights;
+    std::vector<std::int16_t> feature_biases;
+    // nnue_hidden_size weights for the side to move's half, then the same for the other side's
+    std::vector<std::int16_t> output_weights;
+    std::int32_t output_bias{0};
+};
+
+// Writes the little-endian network file that NnueNetwork maps: a 32 byte header followed by the arrays of
+// NnueParameters in order. Throws std::invalid_argument if the arrays have the wrong sizes.
+void save_nnue_network(const std::filesystem::path& path, const NnueParameters& parameters);
+
+// Network weights memory-mapped from a file written by save_nnue_network. Read-only, so one network can be shared
+// by every search thread.
+class NnueNetwork
+{
+  public:
+    // throws std::system_error if the file can't be mapped and std::runtime_error if it isn't a network file
+    explicit NnueNetwork(const std::filesystem::path& path);
+
+    [[nodiscard]] const std::int16_t* feature_weights(const int feature) const noexcept
+    {
+        return feature_weights_ + static_cast<std::ptrdiff_t>(feature) * nnue_hidden_size;
+    }
+    [[nodiscard]] const std::int16_t* feature_biases() const noexcept
+    {
+        return feature_biases_;
+    }
+    [[nodiscard]] const std::int16_t* output_weights() const noexcept
+    {
+        return output_weights_;
+    }
+    [[nodiscard]] std::int32_t output_bias() const noexcept
+    {
+        return output_bias_;
+    }
+
+  private:
+    MappedFile file_;
+    const std::int16_t* feature_weights_{nullptr};
+    const std::int16_t* feature_biases_{nullptr};
+    const std::int16_t* output_weights_{nullptr};
+    std::int32_t output_bias_{0};
+};
+
+// The hidden layer before activation, indexed by perspective colour.
+struct alignas(32) NnueAccumulator
+{
+    std::array<std::array<std::int16_t, nnue_hidden_size>, 2> values;
+};
+
+// Follows a GameBoard through make_move and unmake_move with a stack of accumulators: each move derives a new
+// accumulator from its parent's by the few rows the move changes, and unmaking a move just drops back to the parent.
+// One per search thread.
+class NnueEvaluator
+{
+  public:
+    explicit NnueEvaluator(const NnueNetwork& network);
+
+    // recomputes the accumulator from every piece on the board and starts the stack over from this position
+    void reset(const GameBoard& board);
+    // call after board.make_move
+    void push(const GameBoard& board);
+    // call after board.unmake_move
+    void pop() noexcept;
+
+    // of the position last reset or pushed, from the point of view of the side to move, clamped below mate scores
+    [[nodiscard]] Score evaluate(PieceColor side_to_move) const noexcept;
+
+  private:
+    const NnueNetwork& network_;
+    std::vector<NnueAccumulator> stack_;
+    std::size_t top_{0};
+};
+
+} // namespace chess
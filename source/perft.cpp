@@ -0,0 +1,210 @@
+#include "perft.h"
+
+#include "game.h"
+#include "hash_table.h"
+#include "move.h"
+#include "move_list.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace chess {
+
+// https://www.chessprogramming.org/Perft_Results
+const std::array<PerftReferencePosition, 6> perft_reference_positions{{
+    {
+        "initial position",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        {20, 400, 8'902, 197'281, 4'865'609, 119'060'324},
+    },
+    {
+        "kiwipete",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        {48, 2'039, 97'862, 4'085'603, 193'690'690, 8'031'647'685},
+    },
+    {
+        "position 3",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        {14, 191, 2'812, 43'238, 674'624, 11'030'083},
+    },
+    {
+        "position 4",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        {6, 264, 9'467, 422'333, 15'833'292, 706'045'033},
+    },
+    {
+        "position 5",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        {44, 1'486, 62'379, 2'103'487, 89'941'194, 0},
+    },
+    {
+        "position 6",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        {46, 2'079, 89'890, 3'894'594, 164'075'551, 6'923'051'137},
+    },
+}};
+
+std::uint64_t perft(GameBoard& board, const int depth)
+{
+    if (depth <= 0) {
+        return 1;
+    }
+    MoveList moves;
+    board.generate_legal_moves(moves);
+    if (depth == 1) {
+        return moves.size();
+    }
+    std::uint64_t nodes = 0;
+    for (const auto move : moves) {
+        board.make_move(move);
+        nodes += perft(board, depth - 1);
+        board.unmake_move();
+    }
+    return nodes;
+}
+
+namespace {
+
+// the depth is both mixed into the key and kept in the low byte of the stored value, above it is the node count
+constexpr int hashed_perft_depth_bits = 8;
+constexpr std::uint64_t hashed_perft_depth_mask = (std::uint64_t{1} << hashed_perft_depth_bits) - 1;
+
+LocklessHashTable::Key hashed_perft_key(const GameBoard& board, const int depth)
+{
+    return board.zobrist_key() ^ (static_cast<std::uint64_t>(depth) * 0x9E3779B97F4A7C15ULL);
+}
+
+} // namespace
+
+std::uint64_t hashed_perft(GameBoard& board, const int depth, LocklessHashTable& table)
+{
+    if (depth <= 0) {
+        return 1;
+    }
+    const auto key = hashed_perft_key(board, depth);
+    if (const auto entry = table.probe(key);
+        entry.has_value() && (*entry & hashed_perft_depth_mask) == static_cast<std::uint64_t>(depth)) {
+        return *entry >> hashed_perft_depth_bits;
+    }
+    MoveList moves;
+    board.generate_legal_moves(moves);
+    std::uint64_t nodes = moves.size();
+    if (depth > 1) {
+        nodes = 0;
+        for (const auto move : moves) {
+            board.make_move(move);
+            nodes += hashed_perft(board, depth - 1, table);
+            board.unmake_move();
+        }
+    }
+    table.store(key, (nodes << hashed_perft_depth_bits) | static_cast<std::uint64_t>(depth));
+    return nodes;
+}
+
+std::vector<PerftDivideEntry> perft_divide(GameBoard& board, const int depth)
+{
+    MoveList moves;
+    board.generate_legal_moves(moves);
+    std::vector<PerftDivideEntry> entries;
+    entries.reserve(moves.size());
+    for (const auto move : moves) {
+        board.make_move(move);
+        entries.push_back({move, perft(board, depth - 1)});
+        board.unmake_move();
+    }
+    return entries;
+}
+
+std::uint64_t ParallelPerftResult::nodes() const noexcept
+{
+    return std::accumulate(thread_nodes.begin(), thread_nodes.end(), std::uint64_t{0});
+}
+
+namespace {
+
+// subtrees this shallow are counted by the worker that reaches them rather than split into more tasks
+constexpr int parallel_perft_serial_depth = 3;
+// with a table, only the first two plies are split so that the deeper subtrees can be memoised
+constexpr int hashed_parallel_perft_split_plies = 2;
+
+struct ParallelPerftState
+{
+    // padded to a cache line so workers don't contend on each other's counters
+    struct alignas(64) ThreadNodes
+    {
+        std::uint64_t nodes{0};
+    };
+
+    WorkStealingThreadPool& pool;
+    LocklessHashTable* table;
+    int serial_depth;
+    std::vector<ThreadNodes> thread_nodes;
+    std::vector<std::atomic<std::uint64_t>> root_move_nodes;
+};
+
+void count_subtree(
+    ParallelPerftState& state, GameBoard& board, const int depth, const std::size_t root_move, const std::size_t worker
+)
+{
+    if (depth <= state.serial_depth) {
+        const auto nodes = (state.table != nullptr) ? hashed_perft(board, depth, *state.table) : perft(board, depth);
+        state.thread_nodes[worker].nodes += nodes;
+        state.root_move_nodes[root_move].fetch_add(nodes, std::memory_order_relaxed);
+        return;
+    }
+    MoveList moves;
+    board.generate_legal_moves(moves);
+    for (const auto move : moves) {
+        board.make_move(move);
+        state.pool.submit([&state, child = board, depth, root_move](const std::size_t child_worker) mutable {
+            count_subtree(state, child, depth - 1, root_move, child_worker);
+        });
+        board.unmake_move();
+    }
+}
+
+} // namespace
+
+ParallelPerftResult parallel_perft_divide(
+    const GameBoard& board, const int depth, WorkStealingThreadPool& pool, LocklessHashTable* const table
+)
+{
+    MoveList moves;
+    board.generate_legal_moves(moves);
+    auto state = ParallelPerftState{
+        .pool = pool,
+        .table = table,
+        .serial_depth =
+            (table != nullptr) ? std::max(depth - hashed_parallel_perft_split_plies, 0) : parallel_perft_serial_depth,
+        .thread_nodes = std::vector<ParallelPerftState::ThreadNodes>(pool.size()),
+        .root_move_nodes = std::vector<std::atomic<std::uint64_t>>(moves.size()),
+    };
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        auto child = board;
+        child.make_move(moves[i]);
+        pool.submit([&state, child, depth, i](const std::size_t worker) mutable {
+            count_subtree(state, child, depth - 1, i, worker);
+        });
+    }
+    pool.wait_idle();
+
+    ParallelPerftResult result;
+    result.divide.reserve(moves.size());
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        result.divide.push_back({moves[i], state.root_move_nodes[i].load(std::memory_order_relaxed)});
+    }
+    result.thread_nodes.reserve(state.thread_nodes.size());
+    for (const auto& thread : state.thread_nodes) {
+        result.thread_nodes.push_back(thread.nodes);
+    }
+    return result;
+}
+
+} // namespace chess
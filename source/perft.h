@@ -0,0 +1,51 @@
+#pragma once
+
+#include "game.h"
+#include "hash_table.h"
+#include "move.h"
+#include "thread_pool.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace chess {
+
+struct PerftReferencePosition
+{
+    std::string_view name;
+    std::string_view fen;
+    // node counts indexed by depth - 1
+    std::array<std::uint64_t, 6> node_counts;
+};
+extern const std::array<PerftReferencePosition, 6> perft_reference_positions;
+
+struct PerftDivideEntry
+{
+    Move move;
+    std::uint64_t nodes;
+};
+
+[[nodiscard]] std::uint64_t perft(GameBoard& board, int depth);
+[[nodiscard]] std::vector<PerftDivideEntry> perft_divide(GameBoard& board, int depth);
+// Perft that memoises subtree counts by position and depth in a table that may be shared between threads.
+[[nodiscard]] std::uint64_t hashed_perft(GameBoard& board, int depth, LocklessHashTable& table);
+
+struct ParallelPerftResult
+{
+    std::vector<PerftDivideEntry> divide;
+    // nodes counted by each worker of the pool, indexed by worker
+    std::vector<std::uint64_t> thread_nodes;
+
+    [[nodiscard]] std::uint64_t nodes() const noexcept;
+};
+
+// Same counts as perft_divide, with subtrees split into tasks on the pool. Each task counts a copy of the board, with
+// hashed_perft when a table is given.
+[[nodiscard]] ParallelPerftResult parallel_perft_divide(
+    const GameBoard& board, int depth, WorkStealingThreadPool& pool, LocklessHashTable* table = nullptr
+);
+
+} // namespace chess
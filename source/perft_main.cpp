@@ -0,0 +1,187 @@
+#include "game.h"
+#include "hash_table.h"
+#include "move.h"
+#include "perft.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace chess;
+
+namespace {
+
+constexpr int default_suite_depth = 3;
+constexpr std::string_view usage = "usage: ChessPerft [options] <depth> [fen]\n"
+                                   "       ChessPerft [options] --suite [max depth]\n"
+                                   "options:\n"
+                                   "       --threads <count>  split subtrees across threads, 0 for every hardware thread\n"
+                                   "       --hash <MB>        memoise subtree counts in a hash table of the given size\n";
+
+struct PerftOptions
+{
+    std::unique_ptr<WorkStealingThreadPool> pool;
+    std::unique_ptr<LocklessHashTable> table;
+};
+
+double nodes_per_second(const std::uint64_t nodes, const Stopwatch::Duration elapsed)
+{
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    return (seconds > 0.0) ? static_cast<double>(nodes) / seconds : 0.0;
+}
+
+void print_summary(const std::uint64_t nodes, const Stopwatch::Duration elapsed)
+{
+    const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    fmt::print("nodes: {}\ntime: {} ms\nnodes/sec: {:.0f}\n", nodes, milliseconds, nodes_per_second(nodes, elapsed));
+}
+
+// counts with the pool when there is one, otherwise on the calling thread
+ParallelPerftResult divide(GameBoard& board, const int depth, const PerftOptions& options)
+{
+    if (options.pool != nullptr) {
+        return parallel_perft_divide(board, depth, *options.pool, options.table.get());
+    }
+    if (options.table == nullptr) {
+        return {.divide = perft_divide(board, depth), .thread_nodes = {}};
+    }
+    ParallelPerftResult result;
+    for (const auto& entry : perft_divide(board, 1)) {
+        board.make_move(entry.move);
+        result.divide.push_back({entry.move, hashed_perft(board, depth - 1, *options.table)});
+        board.unmake_move();
+    }
+    return result;
+}
+
+std::uint64_t count_nodes(GameBoard& board, const int depth, const PerftOptions& options)
+{
+    if (options.pool == nullptr) {
+        return (options.table != nullptr) ? hashed_perft(board, depth, *options.table) : perft(board, depth);
+    }
+    return divide(board, depth, options).nodes();
+}
+
+void print_hash_stats(const LocklessHashTable* const table)
+{
+    if (table == nullptr) {
+        return;
+    }
+    const auto stats = table->stats();
+    const auto hit_rate = (stats.probes() > 0) ? 100.0 * static_cast<double>(stats.hits) / stats.probes() : 0.0;
+    fmt::print(
+        "hash: {} entries, {} probes, {} hits ({:.1f}%), {} misses, {} collisions, {} stores\n",
+        table->entry_count(),
+        stats.probes(),
+        stats.hits,
+        hit_rate,
+        stats.misses,
+        stats.collisions,
+        stats.stores
+    );
+}
+
+int run_divide(const int depth, const std::string_view fen, const PerftOptions& options)
+{
+    auto board = GameBoard::from_fen(fen);
+    const auto stopwatch = Stopwatch{};
+    const auto result = divide(board, depth, options);
+    const auto elapsed = stopwatch.elapsed();
+
+    std::uint64_t nodes = 0;
+    for (const auto& entry : result.divide) {
+        fmt::print("{}: {}\n", to_uci_string(entry.move), entry.nodes);
+        nodes += entry.nodes;
+    }
+    fmt::print("\nmoves: {}\n", result.divide.size());
+    for (std::size_t thread = 0; thread < result.thread_nodes.size(); ++thread) {
+        fmt::print("thread {}: {} nodes\n", thread, result.thread_nodes[thread]);
+    }
+    print_summary(nodes, elapsed);
+    return EXIT_SUCCESS;
+}
+
+int run_suite(const int max_depth, const PerftOptions& options)
+{
+    bool all_passed = true;
+    std::uint64_t total_nodes = 0;
+    Stopwatch::Duration total_elapsed{};
+    for (const auto& reference : perft_reference_positions) {
+        fmt::print("{} [{}]\n", reference.name, reference.fen);
+        for (int depth = 1; depth <= max_depth && depth <= static_cast<int>(reference.node_counts.size()); ++depth) {
+            const auto expected = reference.node_counts[depth - 1];
+            if (expected == 0) {
+                continue;
+            }
+            auto board = GameBoard::from_fen(reference.fen);
+            const auto stopwatch = Stopwatch{};
+            const auto nodes = count_nodes(board, depth, options);
+            const auto elapsed = stopwatch.elapsed();
+            total_nodes += nodes;
+            total_elapsed += elapsed;
+
+            const bool passed = nodes == expected;
+            all_passed = all_passed && passed;
+            fmt::print(
+                "  depth {}: {} (expected {}) {} {:.0f} nodes/sec\n",
+                depth,
+                nodes,
+                expected,
+                passed ? "ok" : "FAILED",
+                nodes_per_second(nodes, elapsed)
+            );
+        }
+    }
+    fmt::print("\n");
+    print_summary(total_nodes, total_elapsed);
+    return all_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    try {
+        auto args = std::vector<std::string_view>(argv + 1, argv + argc);
+        PerftOptions options;
+        while (args.size() >= 2 && (args[0] == "--threads" || args[0] == "--hash")) {
+            const auto value = std::stoul(std::string{args[1]});
+            if (args[0] == "--threads") {
+                options.pool = std::make_unique<WorkStealingThreadPool>(
+                    (value == 0) ? WorkStealingThreadPool::default_thread_count() : value
+                );
+            } else {
+                options.table = std::make_unique<LocklessHashTable>(value);
+            }
+            args.erase(args.begin(), args.begin() + 2);
+        }
+
+        if (!args.empty() && args[0] == "--suite") {
+            const auto result =
+                run_suite((args.size() >= 2) ? std::stoi(std::string{args[1]}) : default_suite_depth, options);
+            print_hash_stats(options.table.get());
+            return result;
+        }
+        if (!args.empty()) {
+            const auto fen = (args.size() >= 2) ? args[1] : perft_reference_positions.front().fen;
+            const auto result = run_divide(std::stoi(std::string{args[0]}), fen, options);
+            print_hash_stats(options.table.get());
+            return result;
+        }
+        fmt::print("{}", usage);
+        return EXIT_FAILURE;
+    } catch (const std::exception& error) {
+        fmt::print(stderr, "error: {}\n", error.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include "attacks.h"
+#include "pieces.h"
+
+#include <array>
+
+namespace chess {
+
+// centipawns, from the point of view of the side to move
+using Score = int;
+
+// indexed by PieceType
+inline constexpr std::array<Score, 6> piece_values{100, 320, 330, 500, 900, 0};
+
+[[nodiscard]] constexpr Score piece_value(const PieceType type) noexcept
+{
+    return piece_values[static_cast<int>(type)];
+}
+
+// A score with separate opening and endgame values, blended by the game phase when a position is evaluated.
+struct TaperedScore
+{
+    Score opening{0};
+    Score endgame{0};
+
+    constexpr TaperedScore& operator+=(const TaperedScore other) noexcept
+    {
+        opening += other.opening;
+        endgame += other.endgame;
+        return *this;
+    }
+    constexpr TaperedScore& operator-=(const TaperedScore other) noexcept
+    {
+        opening -= other.opening;
+        endgame -= other.endgame;
+        return *this;
+    }
+    friend constexpr TaperedScore operator-(TaperedScore lhs, const TaperedScore rhs) noexcept
+    {
+        return lhs -= rhs;
+    }
+    friend constexpr bool operator==(TaperedScore, TaperedScore) noexcept = default;
+};
+
+// How much each piece type counts towards the game phase, indexed by PieceType. The starting position has
+// max_phase, and positions with fewer pieces than that are scored closer to the endgame.
+inline constexpr std::array<int, 6> phase_weights{0, 1, 1, 2, 4, 0};
+inline constexpr int max_phase = 24;
+
+[[nodiscard]] constexpr int phase_weight(const PieceType type) noexcept
+{
+    return phase_weights[static_cast<int>(type)];
+}
+
+namespace detail {
+
+using PieceSquareTable = std::array<Score, square_count>;
+
+// Written from white's side with the eighth rank first, so a8 comes first and h1 last.
+// clang-format off
+inline constexpr PieceSquareTable pawn_opening_table{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+inline constexpr PieceSquareTable pawn_endgame_table{
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     20,  20,  20,  20,  20,  20,  20,  20,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+inline constexpr PieceSquareTable knight_table{
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+inline constexpr PieceSquareTable bishop_table{
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+inline constexpr PieceSquareTable rook_table{
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+inline constexpr PieceSquareTable queen_table{
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+inline constexpr PieceSquareTable king_opening_table{
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+inline constexpr PieceSquareTable king_endgame_table{
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+// clang-format on
+
+// indexed by PieceType
+inline constexpr std::array<const PieceSquareTable*, 6> opening_tables{
+    &pawn_opening_table, &knight_table, &bishop_table, &rook_table, &queen_table, &king_opening_table,
+};
+inline constexpr std::array<const PieceSquareTable*, 6> endgame_tables{
+    &pawn_endgame_table, &knight_table, &bishop_table, &rook_table, &queen_table, &king_endgame_table,
+};
+
+// indexed by PieceColor, PieceType and Square
+using PieceSquareScores = std::array<std::array<std::array<TaperedScore, square_count>, 6>, 2>;
+
+constexpr PieceSquareScores make_piece_square_scores() noexcept
+{
+    PieceSquareScores scores{};
+    for (int type = 0; type < 6; ++type) {
+        for (Square square = 0; square < square_count; ++square) {
+            // Square 0 is h1, so white reads the tables backwards and black reads them with the ranks flipped
+            const auto white_index = square_count - 1 - square;
+            const auto black_index = white_index ^ 56;
+            scores[static_cast<int>(PieceColor::white)][type][square] = {
+                (*opening_tables[type])[white_index], (*endgame_tables[type])[white_index]
+            };
+            scores[static_cast<int>(PieceColor::black)][type][square] = {
+                (*opening_tables[type])[black_index], (*endgame_tables[type])[black_index]
+            };
+        }
+    }
+    return scores;
+}
+
+} // namespace detail
+
+inline constexpr detail::PieceSquareScores piece_square_scores = detail::make_piece_square_scores();
+
+// positional bonus for a piece standing on a square, not counting its material value
+[[nodiscard]] constexpr TaperedScore piece_square_score(const Piece piece, const Square square) noexcept
+{
+    return piece_square_scores[static_cast<int>(piece.color)][static_cast<int>(piece.type)][square];
+}
+
+} // namespace chess
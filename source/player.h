@@ -1,6 +1,17 @@
 #pragma once
 
-class Player {
-public:
+#include "game.h"
+#include "move.h"
+
+namespace chess {
+
+class Player
+{
+  public:
     virtual ~Player() = default;
+
+    // Called with the position when it is this player's turn, which must have a legal move.
+    [[nodiscard]] virtual Move select_move(const GameBoard& board) = 0;
 };
+
+} // namespace chess
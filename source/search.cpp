@@ -0,0 +1,439 @@
+#include "search.h"
+
+#include "evaluation.h"
+#include "game.h"
+#include "move.h"
+#include "move_list.h"
+#include "move_ordering.h"
+#include "nnue.h"
+#include "see.h"
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chess {
+
+double SearchReport::nodes_per_second() const noexcept
+{
+    const auto seconds = std::chrono::duration<double>(elapsed).count();
+    return (seconds > 0.0) ? static_cast<double>(nodes) / seconds : 0.0;
+}
+
+double SearchReport::first_move_cutoff_rate() const noexcept
+{
+    return (beta_cutoffs > 0) ? static_cast<double>(first_move_cutoffs) / static_cast<double>(beta_cutoffs) : 0.0;
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// nodes a thread searches between publishing its count and checking the clock and stop flags
+constexpr std::uint64_t stop_check_interval = 1024;
+
+// what positional terms can add on top of a capture's material, for delta pruning in quiescence search
+constexpr Score delta_margin = 200;
+
+struct SharedSearchState
+{
+    const SearchLimits& limits;
+    TranspositionTable& transposition_table;
+    // null to use the hand-written evaluation
+    const NnueNetwork* nnue_network;
+    const std::atomic_bool& stop_requested;
+    Clock::time_point start_time;
+    // set once the main thread has finished, or any thread hits a limit
+    std::atomic_bool stop{false};
+    std::atomic<std::uint64_t> nodes{0};
+};
+
+class SearchWorker
+{
+  public:
+    SearchWorker(SharedSearchState& shared, const GameBoard& board, const int index)
+        : shared_{shared}, board_{board}, index_{index}
+    {
+        if (shared_.nnue_network != nullptr) {
+            nnue_.emplace(*shared_.nnue_network);
+            nnue_->reset(board_);
+        }
+    }
+
+    // iterative deepening on the main thread, which decides when the search ends
+    SearchReport run_main(const Search::IterationCallback& on_iteration);
+    // iterative deepening on a helper thread, until the main thread finishes
+    void run_helper();
+
+  private:
+    SharedSearchState& shared_;
+    GameBoard board_;
+    int index_;
+    MoveOrderingHeuristics heuristics_;
+    // follows board_ when evaluating with a network
+    std::optional<NnueEvaluator> nnue_;
+    // nodes searched by this thread
+    std::uint64_t nodes_{0};
+    // nodes not yet added to the shared count
+    std::uint64_t unpublished_nodes_{0};
+    std::uint64_t beta_cutoffs_{0};
+    std::uint64_t first_move_cutoffs_{0};
+    bool stopped_{false};
+
+    [[nodiscard]] Score search_root(int depth, Move& best_move);
+    [[nodiscard]] Score negamax(int depth, Score alpha, Score beta, int ply);
+    [[nodiscard]] Score quiescence(Score alpha, Score beta, int ply);
+    [[nodiscard]] bool should_stop();
+    void make_move(Move move);
+    void unmake_move();
+    [[nodiscard]] Score evaluate() const;
+    void publish_nodes() noexcept;
+};
+
+SearchReport SearchWorker::run_main(const Search::IterationCallback& on_iteration)
+{
+    MoveList moves;
+    board_.generate_legal_moves(moves);
+    SearchReport report;
+    if (!moves.empty()) {
+        report.best_move = moves[0];
+    }
+
+    for (int depth = 1; !moves.empty() && depth <= shared_.limits.max_depth; ++depth) {
+        auto best_move = report.best_move;
+        const auto score = search_root(depth, best_move);
+        if (stopped_) {
+            break;
+        }
+        publish_nodes();
+        report.best_move = best_move;
+        report.score = score;
+        report.depth = depth;
+        report.nodes = shared_.nodes.load(std::memory_order_relaxed);
+        report.elapsed = Clock::now() - shared_.start_time;
+        report.beta_cutoffs = beta_cutoffs_;
+        report.first_move_cutoffs = first_move_cutoffs_;
+        // Helper threads fill the table for the main thread, so its own iterations can cost next to nothing and a
+        // ratio between them says little. The shared count covers every thread's work up to this depth.
+        report.effective_branching_factor =
+            std::pow(static_cast<double>(report.nodes), 1.0 / static_cast<double>(depth));
+        if (on_iteration) {
+            on_iteration(report);
+        }
+        // a forced mate found at this depth can't be improved on by searching deeper
+        if (is_mate_score(score)) {
+            break;
+        }
+    }
+
+    shared_.stop.store(true, std::memory_order_relaxed);
+    publish_nodes();
+    return report;
+}
+
+void SearchWorker::run_helper()
+{
+    MoveList moves;
+    board_.generate_legal_moves(moves);
+    // half of the helpers start a ply deeper so that threads spread over neighbouring depths
+    for (int depth = 1 + (index_ % 2); !moves.empty() && depth <= shared_.limits.max_depth; ++depth) {
+        // rotating the first move tried at the root makes helpers explore different subtrees first
+        auto best_move = moves[static_cast<std::size_t>(index_ + depth) % moves.size()];
+        (void)search_root(depth, best_move);
+        if (stopped_) {
+            break;
+        }
+    }
+    publish_nodes();
+}
+
+Score SearchWorker::search_root(const int depth, Move& best_move)
+{
+    MoveList moves;
+    board_.generate_legal_moves(moves);
+    // the given move is searched first so that it is kept unless something beats it
+    auto picker = MovePicker{board_, moves, best_move, heuristics_, 0};
+
+    auto alpha = -infinite_score;
+    while (const auto next = picker.next()) {
+        const auto move = *next;
+        make_move(move);
+        const auto score = -negamax(depth - 1, -infinite_score, -alpha, 1);
+        unmake_move();
+        if (stopped_) {
+            break;
+        }
+        if (score > alpha) {
+            alpha = score;
+            best_move = move;
+        }
+    }
+    if (!stopped_) {
+        shared_.transposition_table.store(
+            board_.zobrist_key(),
+            {.move = best_move,
+             .score = score_to_transposition(alpha, 0),
+             .depth = depth,
+             .bound = TranspositionEntry::Bound::exact}
+        );
+    }
+    return alpha;
+}
+
+Score SearchWorker::negamax(const int depth, Score alpha, const Score beta, const int ply)
+{
+    if (depth <= 0) {
+        return quiescence(alpha, beta, ply);
+    }
+    ++nodes_;
+    ++unpublished_nodes_;
+    if (should_stop()) {
+        return draw_score;
+    }
+    // the fifty-move rule leaves out checkmate, so a mate that completes the hundredth halfmove still counts
+    if (board_.is_repetition() || board_.is_draw_by_fifty_move_rule()) {
+        return draw_score;
+    }
+    if (ply >= max_search_ply) {
+        return evaluate();
+    }
+
+    const auto key = board_.zobrist_key();
+    Move hash_move;
+    if (const auto entry = shared_.transposition_table.probe(key)) {
+        hash_move = entry->move;
+        if (entry->depth >= depth) {
+            const auto score = score_from_transposition(entry->score, ply);
+            switch (entry->bound) {
+            case TranspositionEntry::Bound::exact:
+                return score;
+            case TranspositionEntry::Bound::lower:
+                if (score >= beta) {
+                    return score;
+                }
+                break;
+            case TranspositionEntry::Bound::upper:
+                if (score <= alpha) {
+                    return score;
+                }
+                break;
+            }
+        }
+    }
+
+    const auto color = board_.active_color();
+    const auto original_alpha = alpha;
+    auto best_score = -infinite_score;
+    Move best_move;
+    auto moves = staged_moves(board_, hash_move, heuristics_, ply);
+    int moves_searched = 0;
+    while (const auto next = moves.next()) {
+        const auto move = *next;
+        ++moves_searched;
+        make_move(move);
+        const auto score = -negamax(depth - 1, -beta, -alpha, ply + 1);
+        unmake_move();
+        if (stopped_) {
+            return draw_score;
+        }
+        if (score > best_score) {
+            best_score = score;
+            best_move = move;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    ++beta_cutoffs_;
+                    first_move_cutoffs_ += (moves_searched == 1) ? 1 : 0;
+                    if (!move.is_capture() && !move.is_promotion()) {
+                        heuristics_.record_quiet_cutoff(color, move, depth, ply);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+    if (moves_searched == 0) {
+        // no legal moves: prefer the quickest mate and the slowest loss
+        return board_.is_active_in_check() ? -mate_score + ply : draw_score;
+    }
+
+    const auto bound = (best_score >= beta)             ? TranspositionEntry::Bound::lower
+                       : (best_score <= original_alpha) ? TranspositionEntry::Bound::upper
+                                                        : TranspositionEntry::Bound::exact;
+    shared_.transposition_table.store(
+        key,
+        {.move = best_move, .score = score_to_transposition(best_score, ply), .depth = depth, .bound = bound}
+    );
+    return best_score;
+}
+
+// Searches captures until the position is quiet so that the static evaluation is never taken in the middle of an
+// exchange. The side to move can stand pat on the evaluation instead of capturing, except in check, where every
+// evasion is searched.
+Score SearchWorker::quiescence(Score alpha, const Score beta, const int ply)
+{
+    ++nodes_;
+    ++unpublished_nodes_;
+    if (should_stop()) {
+        return draw_score;
+    }
+    if (board_.is_repetition() || board_.is_draw_by_fifty_move_rule()) {
+        return draw_score;
+    }
+    if (ply >= max_search_ply) {
+        return evaluate();
+    }
+
+    const bool in_check = board_.is_active_in_check();
+    MoveList moves;
+    auto best_score = -infinite_score;
+    if (in_check) {
+        board_.generate_legal_moves(moves);
+        if (moves.empty()) {
+            return -mate_score + ply;
+        }
+    } else {
+        best_score = evaluate();
+        if (best_score >= beta) {
+            return best_score;
+        }
+        alpha = std::max(alpha, best_score);
+        board_.generate_legal_captures(moves);
+    }
+
+    const auto stand_pat = best_score;
+    auto picker = MovePicker{board_, moves, Move{}, heuristics_, ply};
+    while (const auto next = picker.next()) {
+        const auto move = *next;
+        if (!in_check) {
+            // a knight or rook is rarely better than a queen, and taking one never is
+            if (move.is_promotion() && move.promotion_type() != PieceType::queen) {
+                continue;
+            }
+            // delta pruning: not even winning the material outright would bring the score up to alpha
+            if (stand_pat + material_gain(board_, move) + delta_margin <= alpha) {
+                continue;
+            }
+            if (see(board_, move) < 0) {
+                continue;
+            }
+        }
+        make_move(move);
+        const auto score = -quiescence(-beta, -alpha, ply + 1);
+        unmake_move();
+        if (stopped_) {
+            return draw_score;
+        }
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    return best_score;
+}
+
+bool SearchWorker::should_stop()
+{
+    if (stopped_) {
+        return true;
+    }
+    const auto nodes = shared_.nodes.load(std::memory_order_relaxed) + unpublished_nodes_;
+    if (nodes >= shared_.limits.max_nodes) {
+        stopped_ = true;
+    } else if (unpublished_nodes_ >= stop_check_interval) {
+        publish_nodes();
+        stopped_ = shared_.stop.load(std::memory_order_relaxed) ||
+                   shared_.stop_requested.load(std::memory_order_relaxed) ||
+                   std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - shared_.start_time) >=
+                       shared_.limits.max_time;
+    }
+    if (stopped_) {
+        shared_.stop.store(true, std::memory_order_relaxed);
+    }
+    return stopped_;
+}
+
+void SearchWorker::make_move(const Move move)
+{
+    board_.make_move(move);
+    if (nnue_) {
+        nnue_->push(board_);
+    }
+}
+
+void SearchWorker::unmake_move()
+{
+    board_.unmake_move();
+    if (nnue_) {
+        nnue_->pop();
+    }
+}
+
+Score SearchWorker::evaluate() const
+{
+    return nnue_ ? nnue_->evaluate(board_.active_color()) : chess::evaluate(board_);
+}
+
+void SearchWorker::publish_nodes() noexcept
+{
+    shared_.nodes.fetch_add(unpublished_nodes_, std::memory_order_relaxed);
+    unpublished_nodes_ = 0;
+}
+
+} // namespace
+
+Search::Search(const SearchLimits limits, const int thread_count, const std::size_t hash_size_mb)
+    : limits_{limits}, transposition_table_{hash_size_mb}
+{
+    set_thread_count(thread_count);
+}
+
+void Search::set_thread_count(const int thread_count)
+{
+    if (thread_count < 0) {
+        throw std::invalid_argument("negative search thread count");
+    }
+    thread_count_ = (thread_count == 0) ? static_cast<int>(std::max(1U, std::thread::hardware_concurrency()))
+                                        : thread_count;
+}
+
+SearchReport Search::run(const GameBoard& board, const IterationCallback& on_iteration)
+{
+    auto shared = SharedSearchState{
+        .limits = limits_,
+        .transposition_table = transposition_table_,
+        .nnue_network = nnue_network_.get(),
+        .stop_requested = stop_requested_,
+        .start_time = Clock::now(),
+    };
+
+    SearchReport report;
+    {
+        std::vector<std::jthread> helpers;
+        helpers.reserve(static_cast<std::size_t>(thread_count_ - 1));
+        for (int index = 1; index < thread_count_; ++index) {
+            helpers.emplace_back([&shared, &board, index] { SearchWorker{shared, board, index}.run_helper(); });
+        }
+        report = SearchWorker{shared, board, 0}.run_main(on_iteration);
+    }
+    report.nodes = shared.nodes.load(std::memory_order_relaxed);
+    report.elapsed = Clock::now() - shared.start_time;
+    return report;
+}
+
+} // namespace chess
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "evaluation.h"
+#include "game.h"
+#include "move.h"
+#include "nnue.h"
+#include "transposition_table.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace chess {
+
+struct SearchLimits
+{
+    int max_depth{max_search_ply};
+    // summed over every search thread
+    std::uint64_t max_nodes{std::numeric_limits<std::uint64_t>::max()};
+    std::chrono::milliseconds max_time{std::chrono::milliseconds::max()};
+};
+
+struct SearchReport
+{
+    using Duration = std::chrono::steady_clock::duration;
+
+    // null when the root position has no legal moves
+    Move best_move;
+    Score score{0};
+    // deepest fully searched iteration
+    int depth{0};
+    std::uint64_t nodes{0};
+    Duration elapsed{};
+
+    // move ordering quality, measured on the main thread only
+    std::uint64_t beta_cutoffs{0};
+    std::uint64_t first_move_cutoffs{0};
+    // the depth-th root of the nodes all threads searched to complete that depth
+    double effective_branching_factor{0.0};
+
+    [[nodiscard]] double nodes_per_second() const noexcept;
+    // fraction of cutoffs caused by the first move searched
+    [[nodiscard]] double first_move_cutoff_rate() const noexcept;
+};
+
+// Negamax alpha-beta search with iterative deepening, a transposition table, staged move ordering and a
+// quiescence search of captures at the leaves. With more than one thread it follows the Lazy SMP model: helper
+// threads search the same root with staggered depths and rotated root move orders, and only communicate with the
+// main thread through the shared lock-free transposition table, which they fill with results the main thread can
+// cut off on. The report always comes from the main thread.
+class Search
+{
+  public:
+    using IterationCallback = std::function<void(const SearchReport&)>;
+
+    explicit Search(
+        SearchLimits limits = {}, int thread_count = 1, std::size_t hash_size_mb = TranspositionTable::default_size_mb
+    );
+
+    [[nodiscard]] const SearchLimits& limits() const noexcept
+    {
+        return limits_;
+    }
+    void set_limits(const SearchLimits& limits) noexcept
+    {
+        limits_ = limits;
+    }
+
+    [[nodiscard]] int thread_count() const noexcept
+    {
+        return thread_count_;
+    }
+    // 0 uses every hardware thread
+    void set_thread_count(int thread_count);
+
+    [[nodiscard]] const TranspositionTable& transposition_table() const noexcept
+    {
+        return transposition_table_;
+    }
+    // forgets everything learned from earlier searches
+    void clear_transposition_table() noexcept
+    {
+        transposition_table_.clear();
+    }
+
+    // Evaluates with the network instead of the hand-written evaluation, or with the hand-written one again when
+    // null. Must not be called while run() is in progress.
+    void set_nnue_network(std::shared_ptr<const NnueNetwork> network) noexcept
+    {
+        nnue_network_ = std::move(network);
+    }
+
+    // Searches until a limit is reached or stop() is called and reports on the last iteration completed by the main
+    // thread, which is also passed to on_iteration as each one completes.
+    SearchReport run(const GameBoard& board, const IterationCallback& on_iteration = {});
+    // May be called from another thread while run() is in progress, or before it starts, in which case run() returns
+    // at once. A stop stays in effect until reset_stop().
+    void stop() noexcept
+    {
+        stop_requested_.store(true, std::memory_order_relaxed);
+    }
+    // call before starting a run() that another thread may stop, so that a stop sent in between isn't lost
+    void reset_stop() noexcept
+    {
+        stop_requested_.store(false, std::memory_order_relaxed);
+    }
+
+  private:
+    SearchLimits limits_;
+    int thread_count_{1};
+    TranspositionTable transposition_table_;
+    std::shared_ptr<const NnueNetwork> nnue_network_;
+    std::atomic_bool stop_requested_{false};
+};
+
+} // namespace chess
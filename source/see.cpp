@@ -0,0 +1,99 @@
+#include "see.h"
+
+#include "attacks.h"
+#include "evaluation.h"
+#include "game.h"
+#include "move.h"
+#include "pieces.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+
+namespace chess {
+
+namespace {
+
+// a king may only take last, so it is worth more than anything that could be won by taking it
+constexpr Score see_king_value = 2 * mate_score;
+
+[[nodiscard]] constexpr Score see_value(const PieceType type) noexcept
+{
+    return (type == PieceType::king) ? see_king_value : piece_value(type);
+}
+
+constexpr std::array exchange_order{
+    PieceType::pawn,
+    PieceType::knight,
+    PieceType::bishop,
+    PieceType::rook,
+    PieceType::queen,
+    PieceType::king,
+};
+
+} // namespace
+
+Score material_gain(const GameBoard& board, const Move move)
+{
+    Score gain = 0;
+    if (move.is_en_passant()) {
+        gain = piece_value(PieceType::pawn);
+    } else if (move.is_capture()) {
+        gain = piece_value(*board.pieces().type_at(to_bitboard(move.to())));
+    }
+    if (move.is_promotion()) {
+        gain += piece_value(move.promotion_type()) - piece_value(PieceType::pawn);
+    }
+    return gain;
+}
+
+Score see(const GameBoard& board, const Move move)
+{
+    if (move.is_castling()) {
+        return 0;
+    }
+    const auto& pieces = board.pieces();
+    const auto to = move.to();
+    const auto from_board = to_bitboard(move.from());
+    auto occupancy = pieces.occupied();
+    occupancy.clear(from_board);
+
+    if (move.is_en_passant()) {
+        occupancy.clear(to_bitboard(en_passant_capture_square(move)));
+    }
+    // gains[d] is the material won by the side making the d-th capture, if the exchange stopped after it
+    std::array<Score, 32> gains{};
+    gains[0] = material_gain(board, move);
+    auto on_square = move.is_promotion() ? move.promotion_type() : *pieces.type_at(from_board);
+
+    auto side = board.inactive_color();
+    std::size_t depth = 0;
+    while (depth + 1 < gains.size()) {
+        // recomputed from the reduced occupancy, which brings in any slider that was behind the last capturer
+        const auto attackers = board.attackers_to(to, occupancy) & pieces.of(side);
+        if (attackers.empty()) {
+            break;
+        }
+        const auto capturer = *std::find_if(exchange_order.begin(), exchange_order.end(), [&](const PieceType type) {
+            return attackers.test_any(pieces.of(type));
+        });
+        // the recaptures that follow can only make this worse, so a side that does better by stopping stops
+        const auto gain = see_value(on_square) - gains[depth];
+        if (gain < -gains[depth]) {
+            break;
+        }
+        gains[++depth] = gain;
+        occupancy.clear(to_bitboard(std::countr_zero((attackers & pieces.of(capturer)).to_ullong())));
+        on_square = capturer;
+        side = opposite_color(side);
+    }
+
+    // each side only makes its capture when that beats stopping before it
+    for (; depth > 0; --depth) {
+        gains[depth - 1] = -std::max(-gains[depth - 1], gains[depth]);
+    }
+    return gains[0];
+}
+
+} // namespace chess
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "evaluation.h"
+#include "game.h"
+#include "move.h"
+
+namespace chess {
+
+// Material the move wins before any reply: the captured piece plus what a promotion adds.
+[[nodiscard]] Score material_gain(const GameBoard& board, Move move);
+
+// Static exchange evaluation: the material the side to move gains from the move and the exchange of captures that
+// follows on its destination square, with both sides always recapturing with their least valuable attacker and
+// free to stop when going on would lose material. Pieces behind a capturer join in as it leaves (x-rays), but pins
+// and checks elsewhere on the board are not considered. Positive for captures that win material.
+[[nodiscard]] Score see(const GameBoard& board, Move move);
+
+} // namespace chess
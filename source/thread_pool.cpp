@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace chess {
+
+namespace {
+
+// identifies the pool and worker the current thread belongs to, if any
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local std::size_t current_worker_index = 0;
+
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(const std::size_t thread_count)
+{
+    if (thread_count == 0) {
+        throw std::invalid_argument("thread pool needs at least one thread");
+    }
+    queues_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    threads_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i] { run_worker(i); });
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        const auto lock = std::lock_guard{state_mutex_};
+        stopping_ = true;
+    }
+    work_available_.notify_all();
+    threads_.clear();
+}
+
+std::size_t WorkStealingThreadPool::default_thread_count() noexcept
+{
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+void WorkStealingThreadPool::submit(Task task)
+{
+    std::size_t queue_index = 0;
+    {
+        const auto lock = std::lock_guard{state_mutex_};
+        ++unfinished_tasks_;
+        ++queued_tasks_;
+        queue_index = (current_pool == this) ? current_worker_index : next_queue_++ % queues_.size();
+    }
+    {
+        auto& queue = *queues_[queue_index];
+        const auto lock = std::lock_guard{queue.mutex};
+        queue.tasks.push_back(std::move(task));
+    }
+    work_available_.notify_one();
+}
+
+void WorkStealingThreadPool::wait_idle()
+{
+    auto lock = std::unique_lock{state_mutex_};
+    idle_.wait(lock, [this] { return unfinished_tasks_ == 0; });
+    if (first_exception_) {
+        std::rethrow_exception(std::exchange(first_exception_, nullptr));
+    }
+}
+
+void WorkStealingThreadPool::run_worker(const std::size_t worker_index)
+{
+    current_pool = this;
+    current_worker_index = worker_index;
+    while (true) {
+        if (auto task = take_task(worker_index)) {
+            std::exception_ptr exception;
+            try {
+                (*task)(worker_index);
+            } catch (...) {
+                exception = std::current_exception();
+            }
+            finish_task(std::move(exception));
+            continue;
+        }
+        auto lock = std::unique_lock{state_mutex_};
+        work_available_.wait(lock, [this] { return stopping_ || queued_tasks_ > 0; });
+        if (stopping_) {
+            return;
+        }
+    }
+}
+
+std::optional<WorkStealingThreadPool::Task> WorkStealingThreadPool::take_task(const std::size_t worker_index)
+{
+    {
+        auto& own = *queues_[worker_index];
+        const auto lock = std::lock_guard{own.mutex};
+        if (!own.tasks.empty()) {
+            auto task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --queued_tasks_;
+            return task;
+        }
+    }
+    for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+        auto& victim = *queues_[(worker_index + offset) % queues_.size()];
+        const auto lock = std::lock_guard{victim.mutex};
+        if (!victim.tasks.empty()) {
+            auto task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queued_tasks_;
+            return task;
+        }
+    }
+    return std::nullopt;
+}
+
+void WorkStealingThreadPool::finish_task(std::exception_ptr exception)
+{
+    bool idle = false;
+    {
+        const auto lock = std::lock_guard{state_mutex_};
+        if (exception && !first_exception_) {
+            first_exception_ = std::move(exception);
+        }
+        idle = --unfinished_tasks_ == 0;
+    }
+    if (idle) {
+        idle_.notify_all();
+    }
+}
+
+} // namespace chess
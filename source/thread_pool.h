@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace chess {
+
+// Fixed set of worker threads, each with its own task deque. A worker runs its newest task first (depth-first, which
+// keeps recursive splitting bounded) and steals the oldest task of another worker when its own deque is empty. Tasks
+// are given the index of the worker running them so callers can keep per-thread state without synchronization.
+class WorkStealingThreadPool
+{
+  public:
+    using Task = std::function<void(std::size_t worker_index)>;
+
+    explicit WorkStealingThreadPool(std::size_t thread_count = default_thread_count());
+    ~WorkStealingThreadPool();
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool(WorkStealingThreadPool&&) = delete;
+    WorkStealingThreadPool& operator=(WorkStealingThreadPool&&) = delete;
+
+    [[nodiscard]] static std::size_t default_thread_count() noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return threads_.size();
+    }
+
+    // Tasks submitted from a worker go on that worker's deque, others are spread round-robin.
+    void submit(Task task);
+
+    // Blocks until every submitted task, including tasks submitted by tasks, has finished. Rethrows the first
+    // exception thrown by a task.
+    void wait_idle();
+
+  private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::jthread> threads_;
+
+    std::mutex state_mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable idle_;
+    // incremented under state_mutex_ before the task is pushed so that sleeping workers can't miss a wakeup
+    std::atomic<std::size_t> queued_tasks_{0};
+    std::size_t unfinished_tasks_{0};
+    std::size_t next_queue_{0};
+    bool stopping_{false};
+    std::exception_ptr first_exception_;
+
+    void run_worker(std::size_t worker_index);
+    [[nodiscard]] std::optional<Task> take_task(std::size_t worker_index);
+    void finish_task(std::exception_ptr exception);
+};
+
+} // namespace chess
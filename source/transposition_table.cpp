@@ -0,0 +1,65 @@
+#include "transposition_table.h"
+
+#include "evaluation.h"
+#include "hash_table.h"
+#include "move.h"
+
+#include <cassert>
+#include <cstdint>
+#include <optional>
+
+namespace chess {
+
+namespace {
+
+// value layout: move in bits 0-15, score in 16-31, depth in 32-39, bound in 40-41 and a bit set in every entry so
+// that no value is zero
+constexpr int score_shift = 16;
+constexpr int depth_shift = 32;
+constexpr int bound_shift = 40;
+constexpr std::uint64_t occupied_bit = std::uint64_t{1} << 42;
+
+} // namespace
+
+std::optional<TranspositionEntry> TranspositionTable::probe(const ZobristKey key) const noexcept
+{
+    const auto value = table_.probe(key);
+    if (!value.has_value()) {
+        return std::nullopt;
+    }
+    return TranspositionEntry{
+        .move = Move::from_raw(static_cast<std::uint16_t>(*value)),
+        .score = static_cast<std::int16_t>(*value >> score_shift),
+        .depth = static_cast<std::uint8_t>(*value >> depth_shift),
+        .bound = static_cast<TranspositionEntry::Bound>((*value >> bound_shift) & 0b11),
+    };
+}
+
+void TranspositionTable::store(const ZobristKey key, const TranspositionEntry& entry) noexcept
+{
+    assert(entry.depth >= 0 && entry.depth <= 0xFF);
+    assert(entry.score >= INT16_MIN && entry.score <= INT16_MAX);
+    const auto value = std::uint64_t{entry.move.raw()} |
+                       (std::uint64_t{static_cast<std::uint16_t>(entry.score)} << score_shift) |
+                       (static_cast<std::uint64_t>(entry.depth) << depth_shift) |
+                       (static_cast<std::uint64_t>(entry.bound) << bound_shift) | occupied_bit;
+    table_.store(key, value);
+}
+
+Score score_to_transposition(const Score score, const int ply) noexcept
+{
+    if (!is_mate_score(score)) {
+        return score;
+    }
+    return (score > 0) ? score + ply : score - ply;
+}
+
+Score score_from_transposition(const Score score, const int ply) noexcept
+{
+    if (!is_mate_score(score)) {
+        return score;
+    }
+    return (score > 0) ? score - ply : score + ply;
+}
+
+} // namespace chess
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "evaluation.h"
+#include "hash_table.h"
+#include "move.h"
+#include "zobrist.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace chess {
+
+struct TranspositionEntry
+{
+    enum class Bound : std::uint8_t
+    {
+        exact,
+        // the score is at least this (the search failed high)
+        lower,
+        // the score is at most this (the search failed low)
+        upper,
+    };
+
+    Move move;
+    Score score;
+    int depth;
+    Bound bound;
+};
+
+// Search results shared between threads, packed into single LocklessHashTable values so entries are verified
+// against their key without locks.
+class TranspositionTable
+{
+  public:
+    static constexpr std::size_t default_size_mb = 16;
+
+    explicit TranspositionTable(std::size_t size_mb = default_size_mb) : table_{size_mb} {}
+
+    [[nodiscard]] std::optional<TranspositionEntry> probe(ZobristKey key) const noexcept;
+    void store(ZobristKey key, const TranspositionEntry& entry) noexcept;
+    // not safe to call while other threads are using the table
+    void clear() noexcept
+    {
+        table_.clear();
+    }
+
+    [[nodiscard]] HashTableStats stats() const noexcept
+    {
+        return table_.stats();
+    }
+
+  private:
+    LocklessHashTable table_;
+};
+
+// Mate scores are stored relative to the node rather than the root so that they stay correct when the position is
+// reached at another ply.
+[[nodiscard]] Score score_to_transposition(Score score, int ply) noexcept;
+[[nodiscard]] Score score_from_transposition(Score score, int ply) noexcept;
+
+} // namespace chess
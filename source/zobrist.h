@@ -0,0 +1,74 @@
+#pragma once
+
+#include "attacks.h"
+#include "pieces.h"
+
+#include <array>
+#include <cstdint>
+
+namespace chess {
+
+using ZobristKey = std::uint64_t;
+
+// Random keys XORed together to identify a position. Generated at compile time from a fixed seed so that keys are
+// stable between runs and builds.
+struct ZobristKeys
+{
+    static constexpr int piece_count = 12;
+    static constexpr int castling_rights_count = 16;
+    static constexpr int file_count = 8;
+
+    std::array<std::array<ZobristKey, square_count>, piece_count> pieces;
+    std::array<ZobristKey, castling_rights_count> castling_rights;
+    std::array<ZobristKey, file_count> en_passant_file;
+    ZobristKey black_to_move;
+};
+
+namespace detail {
+
+// splitmix64
+constexpr ZobristKey next_zobrist_key(std::uint64_t& state) noexcept
+{
+    state += 0x9E3779B97F4A7C15ULL;
+    auto z = state;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys make_zobrist_keys() noexcept
+{
+    std::uint64_t state = 0x2545F4914F6CDD1DULL;
+    ZobristKeys keys{};
+    for (auto& piece_keys : keys.pieces) {
+        for (auto& key : piece_keys) {
+            key = next_zobrist_key(state);
+        }
+    }
+    // no castling rights hashes to zero so that a position without any needs no key
+    for (std::size_t rights = 1; rights < keys.castling_rights.size(); ++rights) {
+        keys.castling_rights[rights] = next_zobrist_key(state);
+    }
+    for (auto& key : keys.en_passant_file) {
+        key = next_zobrist_key(state);
+    }
+    keys.black_to_move = next_zobrist_key(state);
+    return keys;
+}
+
+} // namespace detail
+
+inline constexpr ZobristKeys zobrist_keys = detail::make_zobrist_keys();
+
+[[nodiscard]] constexpr ZobristKey zobrist_piece_key(const Piece piece, const Square square) noexcept
+{
+    const auto index = static_cast<int>(piece.color) * 6 + static_cast<int>(piece.type);
+    return zobrist_keys.pieces[index][square];
+}
+
+[[nodiscard]] constexpr ZobristKey zobrist_en_passant_key(const Square square) noexcept
+{
+    return zobrist_keys.en_passant_file[square % ZobristKeys::file_count];
+}
+
+} // namespace chess
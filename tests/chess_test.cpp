@@ -1,5 +1,748 @@
 #include "gtest/gtest.h"
 
+#include "engine_player.h"
+#include "evaluation.h"
+#include "game.h"
+#include "hash_table.h"
+#include "mate_solver.h"
+#include "move.h"
+#include "move_list.h"
+#include "move_ordering.h"
+#include "nnue.h"
+#include "perft.h"
+#include "piece_square_tables.h"
 #include "pieces.h"
+#include "search.h"
+#include "see.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
 
 TEST(Pieces, None) {}
+
+TEST(Move, PacksSquaresAndFlags)
+{
+    static constexpr auto move = chess::Move{12, 28, chess::Move::double_pawn_push};
+    static_assert(sizeof(move) == 2);
+    static_assert(move.from() == 12 && move.to() == 28);
+    static_assert(move.is_double_pawn_push() && !move.is_capture() && !move.is_promotion());
+
+    static constexpr auto promotion = chess::Move::make_promotion(52, 61, chess::PieceType::knight, true);
+    static_assert(promotion.from() == 52 && promotion.to() == 61);
+    static_assert(promotion.is_promotion() && promotion.is_capture() && !promotion.is_en_passant());
+    static_assert(promotion.promotion_type() == chess::PieceType::knight);
+
+    EXPECT_EQ(chess::to_uci_string(chess::Move{11, 27}), "e2e4");
+}
+
+TEST(Attacks, GeometryTables)
+{
+    // squares count from h1 along the ranks: e1 is 3, e2 11, e4 27 and a8 63
+    static constexpr chess::Square h1 = 0, e1 = 3, a1 = 7, e2 = 11, e4 = 27, e7 = 51, a8 = 63;
+    EXPECT_EQ(chess::knight_attacks(h1).count(), 2);
+    EXPECT_EQ(chess::knight_attacks(e4).count(), 8);
+    EXPECT_EQ(chess::king_attacks(a1).count(), 3);
+    EXPECT_EQ(chess::king_attacks(e4).count(), 8);
+    EXPECT_EQ(chess::pawn_attacks(chess::PieceColor::white, e2), chess::to_bitboard(20) | chess::to_bitboard(18));
+    EXPECT_EQ(chess::pawn_attacks(chess::PieceColor::black, e7), chess::to_bitboard(44) | chess::to_bitboard(42));
+    EXPECT_TRUE(chess::pawn_attacks(chess::PieceColor::white, 56).empty());
+
+    EXPECT_EQ(chess::squares_between(e1, h1), BitBoard{0x06});
+    EXPECT_EQ(chess::squares_between(e1, a1), BitBoard{0x70});
+    EXPECT_EQ(chess::squares_between(h1, a8), chess::squares_between(a8, h1));
+    EXPECT_EQ(chess::squares_between(h1, a8).count(), 6);
+    EXPECT_TRUE(chess::squares_between(e1, e2).empty());
+    EXPECT_TRUE(chess::squares_between(e1, 18).empty());
+
+    EXPECT_EQ(chess::line_through(e1, e4), chess::line_through(e2, e4));
+    EXPECT_EQ(chess::line_through(e1, e4).count(), 8);
+    EXPECT_EQ(chess::line_through(e4, a8) & chess::to_bitboard(h1), chess::to_bitboard(h1));
+    EXPECT_TRUE(chess::line_through(e1, 18).empty());
+}
+
+TEST(Attacks, SquareRangeWalksSetBits)
+{
+    const auto board = chess::to_bitboard(3) | chess::to_bitboard(40) | chess::to_bitboard(63);
+    std::vector<chess::Square> visited;
+    for (const auto square : chess::squares(board)) {
+        visited.push_back(square);
+    }
+    EXPECT_EQ(visited, (std::vector<chess::Square>{3, 40, 63}));
+    EXPECT_EQ(chess::squares(board).size(), 3);
+    EXPECT_TRUE(chess::squares(BitBoard{}).empty());
+    EXPECT_EQ(std::ranges::count_if(chess::squares(board), [](const chess::Square square) { return square > 8; }), 2);
+    EXPECT_EQ(*std::ranges::find(chess::squares(board), 40), 40);
+    static_assert(std::ranges::forward_range<chess::SquareRange>);
+    static_assert(std::ranges::borrowed_range<chess::SquareRange>);
+}
+
+TEST(Attacks, SetwiseMatchesPerSquareLookups)
+{
+    std::mt19937_64 random{2024};
+    for (int trial = 0; trial < 1000; ++trial) {
+        // sparse random sets, so that rays run some way before they are blocked
+        const auto occupied = BitBoard{random() & random()};
+        const auto orthogonal = occupied & BitBoard{random() & random()};
+        const auto diagonal = occupied & BitBoard{random() & random()};
+        BitBoard expected_sliders;
+        BitBoard expected_knights;
+        for (chess::Square square = 0; square < chess::square_count; ++square) {
+            if (orthogonal.test_any(chess::to_bitboard(square))) {
+                expected_sliders |= chess::rook_attacks(square, occupied);
+            }
+            if (diagonal.test_any(chess::to_bitboard(square))) {
+                expected_sliders |= chess::bishop_attacks(square, occupied);
+                expected_knights |= chess::knight_attacks(square);
+            }
+        }
+        EXPECT_EQ(chess::slider_attacks_of(orthogonal, diagonal, occupied), expected_sliders);
+        EXPECT_EQ(chess::knight_attacks_of(diagonal), expected_knights);
+    }
+}
+
+TEST(GameBoard, EncodeMoveMatchesGeneratedMoves)
+{
+    for (const auto& reference : chess::perft_reference_positions) {
+        const auto board = chess::GameBoard::from_fen(reference.fen);
+        chess::MoveList moves;
+        board.generate_legal_moves(moves);
+        for (const auto move : moves) {
+            const auto from = chess::to_bitboard(move.from()).to_position();
+            const auto to = chess::to_bitboard(move.to()).to_position();
+            const auto promotion = move.is_promotion() ? std::optional{move.promotion_type()} : std::nullopt;
+            EXPECT_EQ(board.encode_move({from, to}, promotion), move) << chess::to_uci_string(move);
+        }
+    }
+}
+
+TEST(GameBoard, FenInitialPositionMatchesDefault)
+{
+    auto board = chess::GameBoard::from_fen(chess::perft_reference_positions.front().fen);
+    auto default_board = chess::GameBoard{};
+    EXPECT_EQ(chess::perft(board, 3), chess::perft(default_board, 3));
+}
+
+TEST(GameBoard, FenRejectsMalformedInput)
+{
+    EXPECT_THROW((void)chess::GameBoard::from_fen("8/8/8 w - -"), std::invalid_argument);
+    EXPECT_THROW((void)chess::GameBoard::from_fen("8/8/8/8/8/8/8/8 x - -"), std::invalid_argument);
+}
+
+TEST(GameBoard, UnmakeMoveRestoresPosition)
+{
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        const auto before = board;
+        for (const auto& entry : chess::perft_divide(board, 1)) {
+            board.make_move(entry.move);
+            board.unmake_move();
+            EXPECT_EQ(board.active_color(), before.active_color());
+            for (int row = 0; row < 8; ++row) {
+                for (int column = 0; column < 8; ++column) {
+                    const auto position = chess::GameBoard::Position{row, column};
+                    EXPECT_EQ(board.piece_at(position), before.piece_at(position))
+                        << reference.name << " " << chess::to_uci_string(entry.move);
+                }
+            }
+        }
+        EXPECT_EQ(chess::perft(board, 2), reference.node_counts[1]) << reference.name;
+    }
+}
+
+TEST(GameBoard, EvaluationTermsFollowMoves)
+{
+    // every term summed over the pieces from scratch
+    const auto expect_recounted = [](const chess::GameBoard& board, const std::string& context) {
+        std::array<chess::Score, 2> material{};
+        std::array<chess::TaperedScore, 2> positional{};
+        int phase = 0;
+        for (chess::Square square = 0; square < chess::square_count; ++square) {
+            if (const auto piece = board.pieces().at(chess::to_bitboard(square))) {
+                const auto color = static_cast<std::size_t>(piece->color);
+                material[color] += chess::piece_value(piece->type);
+                positional[color] += chess::piece_square_score(*piece, square);
+                phase += chess::phase_weight(piece->type);
+            }
+        }
+        for (const auto color : {chess::PieceColor::black, chess::PieceColor::white}) {
+            EXPECT_EQ(board.pieces().material(color), material[static_cast<std::size_t>(color)]) << context;
+            EXPECT_EQ(board.pieces().positional_score(color), positional[static_cast<std::size_t>(color)])
+                << context;
+        }
+        EXPECT_EQ(board.pieces().phase(), phase) << context;
+    };
+
+    EXPECT_EQ(chess::evaluate(chess::GameBoard{}), 0);
+    EXPECT_EQ(chess::GameBoard{}.pieces().phase(), chess::max_phase);
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        for (const auto& first : chess::perft_divide(board, 1)) {
+            board.make_move(first.move);
+            for (const auto& second : chess::perft_divide(board, 1)) {
+                board.make_move(second.move);
+                expect_recounted(
+                    board, std::string{reference.name} + " " + chess::to_uci_string(first.move) + " " +
+                               chess::to_uci_string(second.move)
+                );
+                board.unmake_move();
+            }
+            board.unmake_move();
+        }
+        expect_recounted(board, std::string{reference.name});
+    }
+}
+
+TEST(GameBoard, ZobristKeyIdentifiesPositions)
+{
+    const auto initial = chess::GameBoard{};
+    const auto initial_from_fen = chess::GameBoard::from_fen(chess::perft_reference_positions.front().fen);
+    EXPECT_EQ(initial.zobrist_key(), initial_from_fen.zobrist_key());
+
+    // the same position reached by transposed move orders hashes the same, and unmake restores the key
+    auto knights_first = chess::GameBoard{};
+    knights_first.make_move({{7, 6}, {5, 5}});
+    knights_first.make_move({{0, 6}, {2, 5}});
+    knights_first.make_move({{6, 4}, {5, 4}});
+    auto pawn_first = chess::GameBoard{};
+    pawn_first.make_move({{6, 4}, {5, 4}});
+    pawn_first.make_move({{0, 6}, {2, 5}});
+    pawn_first.make_move({{7, 6}, {5, 5}});
+    EXPECT_EQ(knights_first.zobrist_key(), pawn_first.zobrist_key());
+    EXPECT_NE(knights_first.zobrist_key(), initial.zobrist_key());
+    for (int ply = 0; ply < 3; ++ply) {
+        knights_first.unmake_move();
+    }
+    EXPECT_EQ(knights_first.zobrist_key(), initial.zobrist_key());
+
+    // side to move, castling rights and en passant file are all part of the key
+    const auto key = [](const char* fen) { return chess::GameBoard::from_fen(fen).zobrist_key(); };
+    EXPECT_NE(key("4k3/8/8/8/4P3/8/8/4K2R w K - 0 1"), key("4k3/8/8/8/4P3/8/8/4K2R b K - 0 1"));
+    EXPECT_NE(key("4k3/8/8/8/4P3/8/8/4K2R b K - 0 1"), key("4k3/8/8/8/4P3/8/8/4K2R b - - 0 1"));
+    EXPECT_NE(key("4k3/8/8/8/4P3/8/8/4K2R b K - 0 1"), key("4k3/8/8/8/4P3/8/8/4K2R b K e3 0 1"));
+}
+
+TEST(GameBoard, DetectsRepetitionAndFiftyMoveRule)
+{
+    auto board = chess::GameBoard{};
+    const auto shuffle_knights = [&board] {
+        board.make_move({{7, 6}, {5, 5}});
+        board.make_move({{0, 6}, {2, 5}});
+        board.make_move({{5, 5}, {7, 6}});
+        board.make_move({{2, 5}, {0, 6}});
+    };
+    EXPECT_FALSE(board.is_repetition());
+    shuffle_knights();
+    EXPECT_TRUE(board.is_repetition());
+    EXPECT_FALSE(board.is_draw_by_repetition());
+    shuffle_knights();
+    EXPECT_TRUE(board.is_draw_by_repetition());
+    EXPECT_TRUE(board.is_game_over());
+    EXPECT_EQ(board.halfmove_clock(), 8);
+
+    // a pawn move is irreversible, so earlier positions no longer count
+    board.make_move({{6, 4}, {4, 4}});
+    EXPECT_EQ(board.halfmove_clock(), 0);
+    EXPECT_FALSE(board.is_repetition());
+
+    auto endgame = chess::GameBoard::from_fen("4k3/8/8/8/8/8/8/R3K3 w - - 99 80");
+    EXPECT_FALSE(endgame.is_draw_by_fifty_move_rule());
+    endgame.make_move({{7, 0}, {6, 0}});
+    EXPECT_TRUE(endgame.is_draw_by_fifty_move_rule());
+    endgame.unmake_move();
+    EXPECT_EQ(endgame.halfmove_clock(), 99);
+}
+
+TEST(GameBoard, CaptureGenerationMatchesFilteredLegalMoves)
+{
+    const auto expect_captures_match = [](const chess::GameBoard& board, const std::string& context) {
+        chess::MoveList moves;
+        board.generate_legal_moves(moves);
+        std::vector<chess::Move> expected;
+        for (const auto move : moves) {
+            if (move.is_capture() || move.is_promotion()) {
+                expected.push_back(move);
+            }
+        }
+        chess::MoveList captures;
+        board.generate_legal_captures(captures);
+        std::vector<chess::Move> actual(captures.begin(), captures.end());
+        const auto by_value = [](const chess::Move lhs, const chess::Move rhs) {
+            return chess::to_uci_string(lhs) < chess::to_uci_string(rhs);
+        };
+        std::ranges::sort(expected, by_value);
+        std::ranges::sort(actual, by_value);
+        EXPECT_EQ(actual, expected) << context;
+    };
+
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        expect_captures_match(board, std::string{reference.name});
+        for (const auto& entry : chess::perft_divide(board, 1)) {
+            board.make_move(entry.move);
+            expect_captures_match(board, std::string{reference.name} + " " + chess::to_uci_string(entry.move));
+            board.unmake_move();
+        }
+    }
+}
+
+TEST(MoveOrdering, StagedMovesYieldEachLegalMoveOnce)
+{
+    const auto by_value = [](const chess::Move lhs, const chess::Move rhs) {
+        return chess::to_uci_string(lhs) < chess::to_uci_string(rhs);
+    };
+    // the hash move comes from the previous position, so it is often not legal in the next one
+    const auto expect_staged_moves_match = [&](const chess::GameBoard& board, const chess::Move hash_move,
+                                               const chess::MoveOrderingHeuristics& heuristics,
+                                               const std::string& context) {
+        chess::MoveList moves;
+        board.generate_legal_moves(moves);
+        std::vector<chess::Move> expected(moves.begin(), moves.end());
+        for (const auto move : expected) {
+            EXPECT_TRUE(board.is_legal(move)) << context << " " << chess::to_uci_string(move);
+        }
+
+        chess::MoveList captures;
+        board.generate_legal_captures(captures);
+        chess::MoveList quiets;
+        board.generate_legal_quiets(quiets);
+        std::vector<chess::Move> partition(captures.begin(), captures.end());
+        partition.insert(partition.end(), quiets.begin(), quiets.end());
+
+        std::vector<chess::Move> staged;
+        auto generator = chess::staged_moves(board, hash_move, heuristics, 0);
+        while (const auto move = generator.next()) {
+            staged.push_back(*move);
+        }
+        if (board.is_legal(hash_move)) {
+            ASSERT_FALSE(staged.empty()) << context;
+            EXPECT_EQ(staged.front(), hash_move) << context;
+        }
+
+        std::ranges::sort(expected, by_value);
+        std::ranges::sort(partition, by_value);
+        std::ranges::sort(staged, by_value);
+        EXPECT_EQ(partition, expected) << context;
+        EXPECT_EQ(staged, expected) << context;
+    };
+
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        chess::MoveOrderingHeuristics heuristics;
+        chess::Move hash_move;
+        for (const auto& entry : chess::perft_divide(board, 1)) {
+            if (!entry.move.is_capture() && !entry.move.is_promotion()) {
+                heuristics.record_quiet_cutoff(board.active_color(), entry.move, 1, 0);
+            }
+            hash_move = entry.move;
+        }
+        expect_staged_moves_match(board, hash_move, heuristics, std::string{reference.name});
+        for (const auto& entry : chess::perft_divide(board, 1)) {
+            board.make_move(entry.move);
+            expect_staged_moves_match(
+                board, hash_move, heuristics, std::string{reference.name} + " " + chess::to_uci_string(entry.move)
+            );
+            board.unmake_move();
+        }
+    }
+}
+
+TEST(MoveOrdering, StagedMovesComeInStageOrder)
+{
+    // exd5 wins a knight, while Qxh7 loses the queen to the rook
+    const auto board = chess::GameBoard::from_fen("4k2r/7p/8/3n4/4P3/7Q/8/6K1 w - - 0 1");
+    chess::MoveList moves;
+    board.generate_legal_moves(moves);
+    const auto find_move = [&moves](const std::string_view uci) {
+        const auto found = std::ranges::find(moves, uci, [](const chess::Move move) {
+            return chess::to_uci_string(move);
+        });
+        EXPECT_NE(found, moves.end()) << uci;
+        return (found != moves.end()) ? *found : chess::Move{};
+    };
+    const auto hash_move = find_move("g1f1");
+    const auto winning_capture = find_move("e4d5");
+    const auto losing_capture = find_move("h3h7");
+    chess::MoveOrderingHeuristics heuristics;
+    heuristics.record_quiet_cutoff(board.active_color(), find_move("e4e5"), 1, 0);
+    heuristics.record_quiet_cutoff(board.active_color(), find_move("h3g3"), 1, 0);
+    const auto& killers = heuristics.killers(0);
+
+    std::vector<chess::Move> staged;
+    auto generator = chess::staged_moves(board, hash_move, heuristics, 0);
+    while (const auto move = generator.next()) {
+        staged.push_back(*move);
+    }
+    ASSERT_EQ(staged.size(), moves.size());
+    EXPECT_EQ(staged[0], hash_move);
+    EXPECT_EQ(staged[1], winning_capture);
+    EXPECT_EQ(staged[2], killers[0]);
+    EXPECT_EQ(staged[3], killers[1]);
+    for (std::size_t i = 4; i + 1 < staged.size(); ++i) {
+        EXPECT_FALSE(staged[i].is_capture()) << chess::to_uci_string(staged[i]);
+    }
+    EXPECT_EQ(staged.back(), losing_capture);
+}
+
+TEST(GameBoard, StatusFollowsMoves)
+{
+    const auto expect_status_matches = [](const chess::GameBoard& board, const std::string& context) {
+        chess::MoveList moves;
+        board.generate_legal_moves(moves);
+        const auto& status = board.status();
+        EXPECT_EQ(status.legal_move_count, static_cast<int>(moves.size())) << context;
+        EXPECT_EQ(status.in_check, board.is_active_in_check()) << context;
+        std::array<BitBoard, chess::square_count> destinations{};
+        for (const auto move : moves) {
+            destinations[move.from()].set(chess::to_bitboard(move.to()));
+        }
+        EXPECT_TRUE(status.legal_destinations == destinations) << context;
+    };
+
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        expect_status_matches(board, std::string{reference.name});
+        for (const auto& entry : chess::perft_divide(board, 1)) {
+            board.make_move(entry.move);
+            expect_status_matches(board, std::string{reference.name} + " " + chess::to_uci_string(entry.move));
+            board.unmake_move();
+            expect_status_matches(board, std::string{reference.name});
+        }
+    }
+
+    auto mated = chess::GameBoard::from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    EXPECT_FALSE(mated.is_game_over());
+    mated.make_move(chess::GameBoard::PositionMove{{7, 0}, {0, 0}});
+    EXPECT_TRUE(mated.status().is_checkmate());
+    EXPECT_TRUE(mated.is_in_checkmate() && mated.is_game_over());
+    EXPECT_EQ(mated.status().legal_move_count, 0);
+}
+
+TEST(GameBoard, StaticExchangeEvaluation)
+{
+    const auto see = [](const char* fen, const std::string& uci) {
+        const auto board = chess::GameBoard::from_fen(fen);
+        chess::MoveList moves;
+        board.generate_legal_moves(moves);
+        for (const auto move : moves) {
+            if (chess::to_uci_string(move) == uci) {
+                return chess::see(board, move);
+            }
+        }
+        ADD_FAILURE() << uci << " is not legal in " << fen;
+        return chess::Score{0};
+    };
+    // an undefended pawn
+    EXPECT_EQ(see("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5"), 100);
+    // a long exchange on e5, with the queen x-raying through the rook, that loses the knight for a pawn
+    static constexpr auto exchange_fen = "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1";
+    EXPECT_EQ(see(exchange_fen, "d3e5"), 100 - 320);
+    const auto exchange = chess::GameBoard::from_fen(exchange_fen);
+    static constexpr chess::Square e5 = 35;
+    // the knights, the bishop and the rook, but not the pieces behind them
+    EXPECT_EQ(exchange.attackers_to(e5, exchange.pieces().occupied()).count(), 4U);
+    // the king can only recapture when the rook behind the capturer is not there
+    EXPECT_EQ(see("4k3/4r3/8/8/8/8/4R3/4R1K1 w - - 0 1", "e2e7"), 500);
+    EXPECT_EQ(see("4k3/4r3/8/8/8/8/4R3/6K1 w - - 0 1", "e2e7"), 0);
+}
+
+TEST(Perft, ReferencePositions)
+{
+    static constexpr std::uint64_t max_nodes = 100'000;
+    for (const auto& reference : chess::perft_reference_positions) {
+        for (int depth = 1; depth <= static_cast<int>(reference.node_counts.size()); ++depth) {
+            const auto expected = reference.node_counts[depth - 1];
+            if (expected > max_nodes) {
+                break;
+            }
+            auto board = chess::GameBoard::from_fen(reference.fen);
+            EXPECT_EQ(chess::perft(board, depth), expected) << reference.name << " depth " << depth;
+        }
+    }
+}
+
+TEST(Perft, ParallelMatchesSerial)
+{
+    auto pool = chess::WorkStealingThreadPool{4};
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        const auto serial = chess::perft_divide(board, 4);
+        const auto parallel = chess::parallel_perft_divide(board, 4, pool);
+        ASSERT_EQ(parallel.divide.size(), serial.size()) << reference.name;
+        for (std::size_t i = 0; i < serial.size(); ++i) {
+            EXPECT_EQ(parallel.divide[i].move, serial[i].move) << reference.name;
+            EXPECT_EQ(parallel.divide[i].nodes, serial[i].nodes) << reference.name;
+        }
+        EXPECT_EQ(parallel.nodes(), reference.node_counts[3]) << reference.name;
+        EXPECT_EQ(parallel.thread_nodes.size(), pool.size());
+    }
+}
+
+TEST(Perft, HashedMatchesReferenceCounts)
+{
+    auto table = chess::LocklessHashTable{16};
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        EXPECT_EQ(chess::hashed_perft(board, 4, table), reference.node_counts[3]) << reference.name;
+    }
+    const auto stats = table.stats();
+    EXPECT_GT(stats.hits, 0U);
+    EXPECT_EQ(stats.probes(), stats.hits + stats.misses + stats.collisions);
+
+    auto pool = chess::WorkStealingThreadPool{4};
+    table.clear();
+    const auto kiwipete = chess::GameBoard::from_fen(chess::perft_reference_positions[1].fen);
+    EXPECT_EQ(chess::parallel_perft_divide(kiwipete, 4, pool, &table).nodes(), 4'085'603U);
+}
+
+namespace {
+
+chess::NnueParameters make_random_nnue_parameters()
+{
+    auto random = std::mt19937{12345};
+    const auto fill = [&random](std::vector<std::int16_t>& values, const std::size_t size, const int range) {
+        auto distribution = std::uniform_int_distribution<int>{-range, range};
+        values.resize(size);
+        for (auto& value : values) {
+            value = static_cast<std::int16_t>(distribution(random));
+        }
+    };
+    chess::NnueParameters parameters;
+    fill(parameters.feature_weights, std::size_t{chess::nnue_input_size} * chess::nnue_hidden_size, 32);
+    fill(parameters.feature_biases, chess::nnue_hidden_size, 64);
+    fill(parameters.output_weights, 2 * std::size_t{chess::nnue_hidden_size}, 64);
+    parameters.output_bias = 1000;
+    return parameters;
+}
+
+// the network's definition, evaluated directly from the parameters
+chess::Score reference_nnue_evaluation(const chess::NnueParameters& parameters, const chess::GameBoard& board)
+{
+    std::int64_t output = parameters.output_bias;
+    for (const auto perspective : {board.active_color(), board.inactive_color()}) {
+        std::vector<int> hidden(parameters.feature_biases.begin(), parameters.feature_biases.end());
+        for (chess::Square square = 0; square < chess::square_count; ++square) {
+            if (const auto piece = board.pieces().at(chess::to_bitboard(square))) {
+                const auto feature = static_cast<std::size_t>(chess::nnue_feature(perspective, *piece, square));
+                for (std::size_t i = 0; i < hidden.size(); ++i) {
+                    hidden[i] += parameters.feature_weights[feature * chess::nnue_hidden_size + i];
+                }
+            }
+        }
+        const auto weights_offset = (perspective == board.active_color()) ? 0 : std::size_t{chess::nnue_hidden_size};
+        for (std::size_t i = 0; i < hidden.size(); ++i) {
+            const auto activation = std::clamp(hidden[i], 0, chess::nnue_activation_max);
+            output += activation * parameters.output_weights[weights_offset + i];
+        }
+    }
+    return static_cast<chess::Score>(
+        output * chess::nnue_output_scale / (chess::nnue_activation_max * chess::nnue_output_weight_scale)
+    );
+}
+
+} // namespace
+
+TEST(Nnue, IncrementalUpdatesMatchNetworkDefinition)
+{
+    const auto parameters = make_random_nnue_parameters();
+    const auto path = std::filesystem::temp_directory_path() / "chess_test_network.nnue";
+    chess::save_nnue_network(path, parameters);
+    const auto network = std::make_shared<const chess::NnueNetwork>(path);
+
+    auto evaluator = chess::NnueEvaluator{*network};
+    for (const auto& reference : chess::perft_reference_positions) {
+        auto board = chess::GameBoard::from_fen(reference.fen);
+        evaluator.reset(board);
+        const auto root_score = evaluator.evaluate(board.active_color());
+        EXPECT_EQ(root_score, reference_nnue_evaluation(parameters, board)) << reference.name;
+        for (const auto& first : chess::perft_divide(board, 1)) {
+            board.make_move(first.move);
+            evaluator.push(board);
+            for (const auto& second : chess::perft_divide(board, 1)) {
+                board.make_move(second.move);
+                evaluator.push(board);
+                EXPECT_EQ(evaluator.evaluate(board.active_color()), reference_nnue_evaluation(parameters, board))
+                    << reference.name << " " << chess::to_uci_string(first.move) << " "
+                    << chess::to_uci_string(second.move);
+                board.unmake_move();
+                evaluator.pop();
+            }
+            board.unmake_move();
+            evaluator.pop();
+        }
+        EXPECT_EQ(evaluator.evaluate(board.active_color()), root_score) << reference.name;
+    }
+
+    // the search follows its moves with the network too
+    auto search = chess::Search{{.max_depth = 3}};
+    search.set_nnue_network(network);
+    const auto report = search.run(chess::GameBoard::from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"));
+    EXPECT_EQ(chess::to_uci_string(report.best_move), "a1a8");
+    std::filesystem::remove(path);
+}
+
+TEST(Nnue, RejectsMalformedNetworkFiles)
+{
+    const auto path = std::filesystem::temp_directory_path() / "chess_test_malformed.nnue";
+    std::ofstream{path} << "not a network";
+    EXPECT_THROW(chess::NnueNetwork{path}, std::runtime_error);
+    std::filesystem::remove(path);
+    EXPECT_THROW(chess::NnueNetwork{path}, std::system_error);
+    EXPECT_THROW(chess::save_nnue_network(path, chess::NnueParameters{}), std::invalid_argument);
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(EnginePlayer, FindsMateInOne)
+{
+    auto engine = chess::EnginePlayer{{.max_depth = 4}};
+    const auto board = chess::GameBoard::from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    EXPECT_EQ(chess::to_uci_string(engine.select_move(board)), "a1a8");
+    EXPECT_GE(engine.last_report().score, chess::mate_score - chess::max_search_ply);
+}
+
+TEST(EnginePlayer, MatesOnTheFiftiethMove)
+{
+    // the mate completes the hundredth halfmove, and checkmate takes precedence over the fifty-move draw
+    auto engine = chess::EnginePlayer{{.max_depth = 3}};
+    const auto board = chess::GameBoard::from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 99 80");
+    EXPECT_EQ(chess::to_uci_string(engine.select_move(board)), "a1a8");
+    EXPECT_GE(engine.last_report().score, chess::mate_score - chess::max_search_ply);
+}
+
+TEST(EnginePlayer, WinsHangingQueen)
+{
+    auto engine = chess::EnginePlayer{{.max_depth = 3}};
+    const auto board = chess::GameBoard::from_fen("4k3/8/8/3q4/8/8/3R4/4K3 w - - 0 1");
+    EXPECT_EQ(chess::to_uci_string(engine.select_move(board)), "d2d5");
+    EXPECT_EQ(engine.last_report().depth, 3);
+}
+
+TEST(EnginePlayer, SeesPastTheHorizon)
+{
+    // at depth one only the quiescence search sees the pawn recapture that loses the queen
+    auto engine = chess::EnginePlayer{{.max_depth = 1}};
+    const auto board = chess::GameBoard::from_fen("4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1");
+    EXPECT_NE(chess::to_uci_string(engine.select_move(board)), "d1d5");
+}
+
+TEST(EnginePlayer, RespectsNodeBudget)
+{
+    static constexpr std::uint64_t max_nodes = 5'000;
+    auto engine = chess::EnginePlayer{{.max_nodes = max_nodes}};
+    const auto board = chess::GameBoard::from_fen(chess::perft_reference_positions[1].fen);
+    (void)engine.select_move(board);
+    EXPECT_LE(engine.last_report().nodes, max_nodes);
+    EXPECT_GE(engine.last_report().depth, 1);
+}
+
+TEST(EnginePlayer, KeepsAStopSentBeforeTheSearch)
+{
+    // without limits only the stop can end the search, so the test would hang if run() dropped it
+    auto engine = chess::EnginePlayer{chess::SearchLimits{}};
+    const auto board = chess::GameBoard{};
+    engine.stop();
+    EXPECT_TRUE(board.is_legal(engine.select_move(board)));
+
+    auto reset_engine = chess::EnginePlayer{{.max_depth = 2}};
+    reset_engine.stop();
+    reset_engine.reset_stop();
+    (void)reset_engine.select_move(board);
+    EXPECT_EQ(reset_engine.last_report().depth, 2);
+}
+
+TEST(Search, LazySmpAgreesOnForcedMate)
+{
+    // back rank mate in one, searched deeper than needed by four threads sharing one table
+    auto search = chess::Search{{.max_depth = 5}, 4};
+    const auto board = chess::GameBoard::from_fen("6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1");
+    const auto report = search.run(board);
+    EXPECT_EQ(chess::to_uci_string(report.best_move), "d1d8");
+    EXPECT_GE(report.score, chess::mate_score - chess::max_search_ply);
+    EXPECT_GT(search.transposition_table().stats().stores, 0U);
+}
+
+TEST(MateSolver, FindsForcedMates)
+{
+    struct Problem
+    {
+        std::string_view fen;
+        int max_ply;
+        bool checks_only;
+    };
+    const auto problems = std::array{
+        // back rank mate in one
+        Problem{"6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", 1, false},
+        // the same mate completes the hundredth halfmove, and checkmate takes precedence over the fifty-move draw
+        Problem{"6k1/5ppp/8/8/8/8/8/R5K1 w - - 99 80", 1, false},
+        // Morphy's mate in two starts with a quiet rook sacrifice
+        Problem{"kbK5/pp6/1P6/8/8/8/8/R7 w - - 0 1", 3, false},
+        // Philidor's smothered mate in four, all checks
+        Problem{"r6k/6pp/8/6N1/8/1Q6/8/6K1 w - - 0 1", 7, true},
+        // king and queen against king, mate in ten
+        Problem{"8/8/8/4k3/8/8/8/4K2Q w - - 0 1", 19, false},
+    };
+    for (const auto& problem : problems) {
+        auto solver = chess::MateSolver{
+            {.max_ply = problem.max_ply, .initial_max_ply = problem.max_ply, .checks_only = problem.checks_only}
+        };
+        auto board = chess::GameBoard::from_fen(problem.fen);
+        const auto result = solver.solve(board);
+        ASSERT_EQ(result.outcome, chess::MateSolverResult::Outcome::mate) << problem.fen;
+        EXPECT_LE(static_cast<int>(result.line.size()), problem.max_ply) << problem.fen;
+        for (const auto move : result.line) {
+            board.make_move(move);
+        }
+        EXPECT_TRUE(board.is_in_checkmate()) << problem.fen;
+    }
+}
+
+TEST(MateSolver, SolvesPuzzlesQuicklyUnderDefaultLimits)
+{
+    // without a ply cap from the caller the cap widens from a mate in one, so short mates stay cheap
+    auto solver = chess::MateSolver{};
+    for (const auto fen : {
+             "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+             "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - 1 1",
+             "r5rk/5p1p/5R2/4B3/8/8/7P/7K w - - 0 1",
+             "r6k/6pp/8/6N1/8/1Q6/8/6K1 w - - 0 1",
+         }) {
+        auto board = chess::GameBoard::from_fen(fen);
+        const auto result = solver.solve(board);
+        ASSERT_EQ(result.outcome, chess::MateSolverResult::Outcome::mate) << fen;
+        EXPECT_LT(result.nodes, 1'000U) << fen;
+        for (const auto move : result.line) {
+            board.make_move(move);
+        }
+        EXPECT_TRUE(board.is_in_checkmate()) << fen;
+    }
+}
+
+TEST(MateSolver, ReportsMissingMatesAndStopsAtLimits)
+{
+    // a knight can't mate a lone king
+    auto solver = chess::MateSolver{{.max_ply = 7}};
+    const auto knight = solver.solve(chess::GameBoard::from_fen("8/8/8/4k3/8/8/8/3NK3 w - - 0 1"));
+    EXPECT_EQ(knight.outcome, chess::MateSolverResult::Outcome::no_mate);
+    EXPECT_TRUE(knight.line.empty());
+
+    // the queen mates in ten, but not within the node budget
+    solver.set_limits({.max_nodes = 100, .max_ply = 19});
+    const auto queen = solver.solve(chess::GameBoard::from_fen("8/8/8/4k3/8/8/8/4K2Q w - - 0 1"));
+    EXPECT_EQ(queen.outcome, chess::MateSolverResult::Outcome::unknown);
+    EXPECT_TRUE(queen.line.empty());
+    EXPECT_LE(queen.nodes, 100U);
+
+    EXPECT_THROW(chess::MateSolver({}, 0), std::invalid_argument);
+}